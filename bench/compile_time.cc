@@ -0,0 +1,79 @@
+/* Compile time benchmark of type list algorithms used by fsm.hpp.
+ *
+ * The same workload is run against fsm::meta (fsm/type_list.hpp) or,
+ * with BENCH_META defined, against ericniebler/meta. It is only meant to
+ * be compiled, `make bench-compile` times both with -fsyntax-only.
+ * BENCH_SIZE sets length of lists, operations scale with its square. */
+#ifdef BENCH_META
+#	include <meta/meta.hpp>
+namespace tl = ::meta;
+#else
+#	include <fsm/type_list.hpp>
+namespace tl = fsm::meta;
+#endif
+
+#include <cstddef>
+#include <type_traits>
+
+#ifndef BENCH_SIZE
+#	define BENCH_SIZE 128
+#endif
+
+namespace
+{
+
+template<std::size_t I>
+struct tag : public std::integral_constant<std::size_t, I> {};
+
+template<typename> struct make_tags;
+
+template<std::size_t... Is>
+struct make_tags<tl::index_sequence<Is...>>
+{
+	using type = tl::list<tag<Is>...>;
+	// every tag twice, as start and stop states of a transition table
+	using twice = tl::list<tag<Is>..., tag<Is>...>;
+
+	template<typename L>
+	using counts = tl::list<tl::count<L, tag<Is>>...>;
+
+	template<typename L>
+	using indices = tl::list<tl::find_index<L, tag<Is>>...>;
+
+	template<typename L>
+	using elements = tl::list<tl::at_c<L, Is>...>;
+};
+
+using tags = make_tags<tl::make_index_sequence<BENCH_SIZE>>;
+
+template<std::size_t N>
+struct is_below {
+	template<typename T>
+	using invoke = tl::bool_<(T::value < N)>;
+};
+
+struct next_func {
+	template<typename T>
+	using invoke = tag<T::value + 1>;
+};
+
+template<typename... Ts>
+struct use {};
+
+// all operations fsm.hpp instantiates per table, for every state
+using workload = use<
+	tl::unique<tags::twice>,
+	tl::transform<tags::type, next_func>,
+	tl::filter<tags::type, is_below<BENCH_SIZE / 2>>,
+	tl::find_if<tags::type, is_below<1>>,
+	tl::concat<tags::type, tags::type, tags::type>,
+	tags::counts<tags::twice>,
+	tags::indices<tags::type>,
+	tags::elements<tags::type>>;
+
+static_assert(tl::unique<tags::twice>::size() == BENCH_SIZE, "");
+static_assert(tl::find_index<tags::type, tag<BENCH_SIZE - 1>>::value == BENCH_SIZE - 1, "");
+
+} // namespace
+
+workload *bench_workload();
@@ -0,0 +1,109 @@
+/* Throughput of fsm::dfa over text.
+ *
+ * A tokenizer-like table runs over random words, numbers and blanks of
+ * growing length. Baseline is a plain walk over the class map and the
+ * state table one byte at a time, feed() additionally skips runs keeping
+ * the state (16 bytes at a time with SSSE3). */
+#include <fsm/dfa.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace
+{
+
+using letter = fsm::char_range<'a', 'z'>;
+using digit = fsm::char_range<'0', '9'>;
+using blank = fsm::chars<' ', '\t', '\n'>;
+
+template<std::size_t ID>
+struct S : public fsm::state<ID> {};
+
+using table = fsm::transitions<
+	fsm::transition<S<0>, letter, S<1>>,
+	fsm::transition<S<0>, digit, S<2>>,
+	fsm::transition<S<0>, blank, S<3>>,
+	fsm::transition<S<0>, fsm::other_bytes, S<0>>,
+	fsm::transition<S<1>, letter, S<1>>,
+	fsm::transition<S<1>, digit, S<1>>,
+	fsm::transition<S<1>, blank, S<3>>,
+	fsm::transition<S<1>, fsm::other_bytes, S<0>>,
+	fsm::transition<S<2>, digit, S<2>>,
+	fsm::transition<S<2>, blank, S<3>>,
+	fsm::transition<S<2>, fsm::other_bytes, S<0>>,
+	fsm::transition<S<3>, blank, S<3>>,
+	fsm::transition<S<3>, letter, S<1>>,
+	fsm::transition<S<3>, digit, S<2>>,
+	fsm::transition<S<3>, fsm::other_bytes, S<0>>
+>;
+
+using dfa = fsm::dfa<table>;
+
+constexpr std::size_t size = 64 * 1024 * 1024;
+
+std::string make_text(std::size_t run)
+{
+	std::mt19937 gen(3);
+	std::uniform_int_distribution<std::size_t> length(1, 2 * run);
+	std::uniform_int_distribution<int> letters('a', 'z');
+	std::uniform_int_distribution<int> digits('0', '9');
+	std::string text;
+
+	while (text.size() < size) {
+		const std::size_t n = length(gen);
+
+		if (gen() % 2) {
+			for (std::size_t i = 0; i < n; ++i) {
+				text += static_cast<char>(letters(gen));
+			}
+		} else {
+			for (std::size_t i = 0; i < n; ++i) {
+				text += static_cast<char>(digits(gen));
+			}
+		}
+
+		text += gen() % 4 ? ' ' : ',';
+	}
+
+	return text;
+}
+
+template<typename F>
+double measure(F f)
+{
+	auto start = std::chrono::steady_clock::now();
+	f();
+	auto stop = std::chrono::steady_clock::now();
+	return size / std::chrono::duration<double, std::micro>(stop - start).count();
+}
+
+}
+
+int main()
+{
+	for (std::size_t run : {2, 8, 32, 128}) {
+		const std::string text = make_text(run);
+		const unsigned char *bytes = reinterpret_cast<const unsigned char *>(text.data());
+		dfa::index_t walked = 0;
+		std::size_t consumed = 0;
+		dfa m;
+
+		const double walk = measure([&] {
+			dfa::index_t s = 0;
+
+			for (std::size_t i = 0; i < size; ++i) {
+				s = dfa::step(s, bytes[i]);
+			}
+
+			walked = s;
+		});
+
+		const double feed = measure([&] {
+			consumed = m.feed(text.data(), size);
+		});
+
+		std::printf("runs of ~%3zu bytes: walk %8.1f MB/s, feed %8.1f MB/s (states %u %u, %zu bytes)\n",
+			run, walk, feed, unsigned(walked), unsigned(m.currentIndex()), consumed);
+	}
+}
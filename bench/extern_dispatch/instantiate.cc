@@ -0,0 +1,6 @@
+/* The only unit instantiating dispatch when FSM_BENCH_EXTERN is set. */
+#include "machine.hpp"
+
+#ifdef FSM_BENCH_EXTERN
+FSM_INSTANTIATE_DISPATCH(bench::machine, bench::Next, bench::Back, bench::Skip, bench::Reset);
+#endif
@@ -0,0 +1,53 @@
+/* Machine shared by all translation units of the extern dispatch
+ * benchmark. With FSM_BENCH_EXTERN its dispatch is instantiated only in
+ * instantiate.cc, otherwise every unit instantiates it again. */
+#ifndef FSM_BENCH_MACHINE_HPP
+#define FSM_BENCH_MACHINE_HPP
+
+#include <fsm.hpp>
+
+namespace bench
+{
+
+constexpr std::size_t states = 48;
+
+struct Next {};
+struct Back {};
+struct Skip {};
+struct Reset {};
+
+template<std::size_t ID>
+struct S : public fsm::state<ID>
+{
+	void enter() { ++visits; }
+	void exit() {}
+
+	bool event(const Next &) { return true; }
+	bool event(const Back &) { return true; }
+	bool event(const Skip &) { return ID % 2 == 0; }
+	bool event(const Reset &) { return true; }
+
+	unsigned visits = 0;
+};
+
+template<std::size_t... Is>
+fsm::transitions<
+	fsm::transition<S<Is>, Next, S<(Is + 1) % states>>...,
+	fsm::transition<S<Is>, Back, S<(Is + states - 1) % states>>...,
+	fsm::transition<S<Is>, Skip, S<(Is + 7) % states>>...,
+	fsm::transition<S<Is + 1>, Reset, S<0>>...
+> make_table(fsm::meta::index_sequence<Is...>);
+
+using table = decltype(make_table(fsm::meta::make_index_sequence<states - 1>{}));
+using machine = fsm::fsm<table>;
+
+// each translation unit drives the machine through its own function
+unsigned unit(machine &m, unsigned steps);
+
+} // namespace bench
+
+#ifdef FSM_BENCH_EXTERN
+FSM_EXTERN_DISPATCH(bench::machine, bench::Next, bench::Back, bench::Skip, bench::Reset);
+#endif
+
+#endif // FSM_BENCH_MACHINE_HPP
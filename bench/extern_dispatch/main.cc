@@ -0,0 +1,35 @@
+/* Compile and link time benchmark of FSM_EXTERN_DISPATCH.
+ *
+ * The same set of translation units is built twice: bench-extern-implicit
+ * instantiates dispatch of the machine in every unit and leaves it to the
+ * linker to fold the copies, bench-extern-explicit instantiates it once.
+ * Compare `time make bench-extern-implicit` with
+ * `time make bench-extern-explicit` after `make clean`. */
+#include "machine.hpp"
+#include <cstdio>
+
+#define FSM_BENCH_DECLARE(n) namespace bench { unsigned unit_##n(machine &, unsigned); }
+FSM_BENCH_DECLARE(0) FSM_BENCH_DECLARE(1) FSM_BENCH_DECLARE(2) FSM_BENCH_DECLARE(3)
+FSM_BENCH_DECLARE(4) FSM_BENCH_DECLARE(5) FSM_BENCH_DECLARE(6) FSM_BENCH_DECLARE(7)
+FSM_BENCH_DECLARE(8) FSM_BENCH_DECLARE(9) FSM_BENCH_DECLARE(10) FSM_BENCH_DECLARE(11)
+FSM_BENCH_DECLARE(12) FSM_BENCH_DECLARE(13) FSM_BENCH_DECLARE(14) FSM_BENCH_DECLARE(15)
+
+int main()
+{
+	using namespace bench;
+
+	unsigned (*units[])(machine &, unsigned) = {
+		unit_0, unit_1, unit_2, unit_3, unit_4, unit_5, unit_6, unit_7,
+		unit_8, unit_9, unit_10, unit_11, unit_12, unit_13, unit_14, unit_15,
+	};
+
+	machine m;
+	unsigned taken = 0;
+
+	for (auto unit : units) {
+		taken += unit(m, 1000);
+	}
+
+	std::printf("%u transitions, state %zu\n", taken, m.currentState());
+	return 0;
+}
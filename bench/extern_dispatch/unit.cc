@@ -0,0 +1,28 @@
+/* One of many translation units using the machine, compiled once per
+ * FSM_BENCH_UNIT value. */
+#include "machine.hpp"
+
+namespace bench
+{
+
+#define FSM_BENCH_CAT(a, b) a##b
+#define FSM_BENCH_NAME(a, b) FSM_BENCH_CAT(a, b)
+
+unsigned FSM_BENCH_NAME(unit_, FSM_BENCH_UNIT)(machine &m, unsigned steps)
+{
+	unsigned taken = 0;
+
+	for (unsigned i = 0; i < steps; ++i) {
+		taken += m.on(Next{});
+		taken += m.on(Skip{});
+		taken += m.on(Back{});
+
+		if (i % 64 == FSM_BENCH_UNIT) {
+			taken += m.on(Reset{});
+		}
+	}
+
+	return taken;
+}
+
+} // namespace bench
@@ -0,0 +1,213 @@
+/* Skewed traffic benchmark for fsm::hot transitions.
+ *
+ * A fleet of machines where almost every machine sits in the same state
+ * and almost every event is the same one. The same table is dispatched
+ * with and without the (state, event) pair marked as hot. Branch
+ * mispredictions of the dispatch loop are read from the hardware counter
+ * on Linux, they are not shown where perf events are not available (no
+ * PMU in a virtual machine, kernel.perf_event_paranoid too strict). */
+#include <fsm.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#if defined(__linux__)
+#	include <linux/perf_event.h>
+#	include <sys/ioctl.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+namespace
+{
+
+struct Data {};
+struct Tick {};
+
+template<std::size_t ID>
+struct S : public fsm::state<ID>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Data &) { ++ count; return true; }
+	bool event(const Tick &) { return true; }
+
+	unsigned count = 0;
+};
+
+template<typename T> using plain = T;
+template<typename T> using marked = fsm::hot<T>;
+
+/* Hot wraps (S<10>, Data) only, everything else stays plain */
+template<template<typename> class Hot>
+using table = fsm::transitions<
+	fsm::transition<S<0>, Data, S<0>>,
+	fsm::transition<S<1>, Data, S<1>>,
+	fsm::transition<S<2>, Data, S<2>>,
+	fsm::transition<S<3>, Data, S<3>>,
+	fsm::transition<S<4>, Data, S<4>>,
+	fsm::transition<S<5>, Data, S<5>>,
+	fsm::transition<S<6>, Data, S<6>>,
+	fsm::transition<S<7>, Data, S<7>>,
+	fsm::transition<S<8>, Data, S<8>>,
+	fsm::transition<S<9>, Data, S<9>>,
+	Hot<fsm::transition<S<10>, Data, S<10>>>,
+	fsm::transition<S<11>, Data, S<11>>,
+
+	fsm::transition<S<0>, Tick, S<1>>,
+	fsm::transition<S<1>, Tick, S<2>>,
+	fsm::transition<S<2>, Tick, S<3>>,
+	fsm::transition<S<3>, Tick, S<4>>,
+	fsm::transition<S<4>, Tick, S<5>>,
+	fsm::transition<S<5>, Tick, S<6>>,
+	fsm::transition<S<6>, Tick, S<7>>,
+	fsm::transition<S<7>, Tick, S<8>>,
+	fsm::transition<S<8>, Tick, S<9>>,
+	fsm::transition<S<9>, Tick, S<10>>,
+	fsm::transition<S<10>, Tick, S<11>>,
+	fsm::transition<S<11>, Tick, S<0>>
+>;
+
+/* branch misses of this thread in user space */
+class branch_misses
+{
+public:
+	branch_misses()
+	{
+#if defined(__linux__)
+		perf_event_attr attr{};
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+
+	~branch_misses()
+	{
+#if defined(__linux__)
+		if (fd >= 0) {
+			close(fd);
+		}
+#endif
+	}
+
+	branch_misses(const branch_misses &) = delete;
+	branch_misses &operator=(const branch_misses &) = delete;
+
+	bool available() const
+	{
+		return fd >= 0;
+	}
+
+	void start()
+	{
+#if defined(__linux__)
+		if (fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	/* misses since start(), zero if not available */
+	long long stop()
+	{
+		long long count = 0;
+
+#if defined(__linux__)
+		if (fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+			if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+				count = 0;
+			}
+		}
+#endif
+
+		return count;
+	}
+
+private:
+	int fd = -1;
+};
+
+struct result {
+	double ns;
+	long long misses;
+};
+
+constexpr std::size_t machines = 4096;
+constexpr std::size_t events = 50 * 1000 * 1000;
+
+template<template<typename> class Hot>
+result run(const std::vector<std::uint32_t> &targets, const std::vector<std::uint32_t> &positions,
+	branch_misses &counter)
+{
+	std::vector<fsm::fsm<table<Hot>>> fleet(machines);
+
+	/* spread 1% of the fleet over the cold states, the rest goes to S<10> */
+	for (std::size_t m = 0; m < machines; ++m) {
+		for (std::uint32_t i = 0; i < positions[m]; ++i) {
+			fleet[m].on(Tick{});
+		}
+	}
+
+	counter.start();
+	auto start = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < events; ++i) {
+		fleet[targets[i]].on(Data{});
+	}
+
+	auto stop = std::chrono::steady_clock::now();
+	const long long misses = counter.stop();
+
+	return {std::chrono::duration<double, std::nano>(stop - start).count() / events, misses};
+}
+
+void print(const char *name, const result &r, const branch_misses &counter)
+{
+	std::printf("%s %.2f ns/event", name, r.ns);
+
+	if (counter.available()) {
+		std::printf(", %.4f branch misses/event (%lld)", double(r.misses) / events, r.misses);
+	}
+
+	std::printf("\n");
+}
+
+}
+
+int main()
+{
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<std::uint32_t> machine(0, machines - 1);
+	std::uniform_int_distribution<std::uint32_t> percent(0, 99);
+	std::uniform_int_distribution<std::uint32_t> cold(0, 11);
+
+	std::vector<std::uint32_t> positions(machines);
+	for (auto &p : positions) {
+		p = percent(gen) == 0 ? cold(gen) : 10;
+	}
+
+	std::vector<std::uint32_t> targets(events);
+	for (auto &t : targets) {
+		t = machine(gen);
+	}
+
+	branch_misses counter;
+
+	if (!counter.available()) {
+		std::printf("branch miss counter not available\n");
+	}
+
+	print("plain:", run<plain>(targets, positions, counter), counter);
+	print("hot:  ", run<marked>(targets, positions, counter), counter);
+}
@@ -0,0 +1,87 @@
+/* Bulk replay benchmark for fsm::replay.
+ *
+ * A long random log over a 12 state table (one pshufb per event when
+ * composing) is replayed with growing number of threads, only the final
+ * state and with all intermediate states. One thread is a plain table
+ * walk and the baseline. */
+#include <fsm/replay.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Next {};
+struct Back {};
+struct Jump {};
+
+template<std::size_t ID>
+struct S : public fsm::state<ID>
+{
+	using behavior_free = std::true_type;
+
+	void enter() {}
+	void exit() {}
+
+	template<typename E>
+	bool event(const E &) { return true; }
+};
+
+constexpr std::size_t states = 12;
+
+template<std::size_t... Is>
+fsm::transitions<
+	fsm::transition<S<Is>, Next, S<(Is + 1) % states>>...,
+	fsm::transition<S<Is>, Back, S<(Is + states - 1) % states>>...,
+	fsm::transition<S<Is * 7 % states>, Jump, S<Is * 5 % states>>...
+> make_table(fsm::meta::index_sequence<Is...>);
+
+using table = decltype(make_table(fsm::meta::make_index_sequence<states>{}));
+using replay = fsm::replay<table>;
+
+constexpr std::size_t events = 256 * 1024 * 1024;
+
+template<typename F>
+double measure(F f)
+{
+	auto start = std::chrono::steady_clock::now();
+	f();
+	auto stop = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(stop - start).count() / events;
+}
+
+}
+
+int main()
+{
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<int> pick(0, 2);
+
+	const replay::code_t codes[] = {replay::code<Next>(), replay::code<Back>(), replay::code<Jump>()};
+	std::vector<replay::code_t> log(events);
+
+	for (auto &c : log) {
+		c = codes[pick(gen)];
+	}
+
+	std::vector<replay::index_t> trace(events);
+	const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned threads = 1; threads <= hardware; threads *= 2) {
+		replay::index_t last = 0;
+
+		const double final_ns = measure([&] {
+			last = replay::finalState(log.data(), log.size(), 0, threads);
+		});
+
+		const double trace_ns = measure([&] {
+			replay::trace(log.data(), log.size(), trace.data(), 0, threads);
+		});
+
+		std::printf("%2u threads: final %.3f ns/event, trace %.3f ns/event (state %u)\n",
+			threads, final_ns, trace_ns, unsigned(last));
+	}
+}
@@ -0,0 +1,45 @@
+# fsm_generate_table(<target> NAME <type> INPUT <file>
+#                    [NAMESPACE <ns>] [INCLUDES <header>...] [OUTPUT <header>])
+#
+# generates header defining fsm::transitions table <type> from textual or
+# DOT description (see tools/fsm-gen.cc) and makes it available to target.
+# Header is written to OUTPUT, by default <type>.hpp in generated-tables directory
+# of current binary directory which is added to include path of target.
+function(fsm_generate_table target)
+	cmake_parse_arguments(GEN "" "NAME;INPUT;NAMESPACE;OUTPUT" "INCLUDES" ${ARGN})
+
+	if (NOT GEN_NAME OR NOT GEN_INPUT)
+		message(FATAL_ERROR "fsm_generate_table needs NAME and INPUT")
+	endif()
+
+	get_filename_component(input ${GEN_INPUT} ABSOLUTE)
+
+	if (GEN_OUTPUT)
+		set(output ${GEN_OUTPUT})
+	else()
+		set(output ${CMAKE_CURRENT_BINARY_DIR}/generated-tables/${GEN_NAME}.hpp)
+	endif()
+
+	get_filename_component(output-dir ${output} DIRECTORY)
+
+	set(args)
+
+	if (GEN_NAMESPACE)
+		list(APPEND args --namespace ${GEN_NAMESPACE})
+	endif()
+
+	foreach (include ${GEN_INCLUDES})
+		list(APPEND args --include ${include})
+	endforeach()
+
+	add_custom_command(
+		OUTPUT ${output}
+		COMMAND ${CMAKE_COMMAND} -E make_directory ${output-dir}
+		COMMAND fsm-gen ${args} ${GEN_NAME} ${input} ${output}
+		DEPENDS fsm-gen ${input}
+		COMMENT "Generating transition table ${GEN_NAME}"
+		VERBATIM)
+
+	target_sources(${target} PRIVATE ${output})
+	target_include_directories(${target} PRIVATE ${output-dir})
+endfunction()
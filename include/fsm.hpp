@@ -1,219 +1,2159 @@
 #ifndef FSM_HPP
 #define FSM_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
 #include <tuple>
-#include <meta/meta.hpp>
+#include <type_traits>
+#include <fsm/type_list.hpp>
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define FSM_LIKELY(x) __builtin_expect(!!(x), 1)
+#	define FSM_COLD __attribute__((cold, noinline))
+#	define FSM_DEPRECATED(msg) __attribute__((deprecated(msg)))
+#	define FSM_CTZ(x) static_cast<std::size_t>(__builtin_ctzll(x))
+#else
+#	define FSM_LIKELY(x) (x)
+#	define FSM_COLD
+#	define FSM_DEPRECATED(msg)
+#	define FSM_CTZ(x) ::fsm::detail::count_trailing_zeros(x)
+#endif
+
+#if defined(_MSC_VER) && defined(_WIN64)
+#	include <intrin.h>
+#endif
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#	define FSM_EXCEPTIONS 1
+#else
+#	define FSM_EXCEPTIONS 0
+#endif
+
+// fsm::fsm::on() accepts std::variant of events since C++17
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#	define FSM_VARIANT 1
+#	include <variant>
+#else
+#	define FSM_VARIANT 0
+#endif
 
 namespace fsm
 {
 
-namespace detail
+namespace detail
+{
+struct null_context {};
+
+// index of the lowest set bit of nonzero x, FSM_CTZ of compilers
+// without __builtin_ctzll
+inline std::size_t count_trailing_zeros(std::uint64_t x) noexcept
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long i;
+	_BitScanForward64(&i, x);
+	return i;
+#else
+	std::size_t i = 0;
+
+	for (; (x & 1) == 0; x >>= 1) {
+		++i;
+	}
+
+	return i;
+#endif
+}
+
+template<typename...>
+struct make_void
+{
+	using type = void;
+};
+
+// smallest unsigned integer type able to hold every value in [0, N]
+template<std::size_t N>
+using index_type = typename std::conditional<
+	N <= UINT8_MAX,
+	std::uint8_t,
+	typename std::conditional<
+		N <= UINT16_MAX,
+		std::uint16_t,
+		std::uint32_t
+	>::type
+>::type;
+
+// list of std::integral_constant<std::size_t, I> for all I in [0, N)
+template<typename> struct index_list_impl;
+
+template<std::size_t... Is>
+struct index_list_impl<meta::index_sequence<Is...>>
+{
+	using type = meta::list<std::integral_constant<std::size_t, Is>...>;
+};
+
+template<std::size_t N>
+using index_list = typename index_list_impl<meta::make_index_sequence<N>>::type;
+
+// split list in two halves, first one gets N elements
+template<std::size_t N, typename Head, typename Tail> struct split_impl;
+
+template<typename... Hs, typename T, typename... Ts>
+struct split_impl<0, meta::list<Hs...>, meta::list<T, Ts...>>
+{
+	using first = meta::list<Hs...>;
+	using second = meta::list<T, Ts...>;
+};
+
+template<std::size_t N, typename... Hs, typename T, typename... Ts>
+struct split_impl<N, meta::list<Hs...>, meta::list<T, Ts...>> :
+	public split_impl<N - 1, meta::list<Hs..., T>, meta::list<Ts...>>
+{
+};
+
+template<typename L>
+using split = split_impl<L::size() / 2, meta::list<>, L>;
+
+// IDs of all states, indexed by state index. Last one is for machine
+// which was not started yet.
+template<typename> struct state_ids;
+
+template<typename... States>
+struct state_ids<std::tuple<States...>>
+{
+	static constexpr std::size_t value[] = {States::value..., 0};
+};
+
+template<typename... States>
+constexpr std::size_t state_ids<std::tuple<States...>>::value[];
+
+// perfect hash of state IDs: id % modulus is distinct for every state.
+// Smallest modulus not below number of states is searched for, for IDs
+// numbered from 0 or 1 it ends up being a plain dense array. Recursion
+// always splits ranges in halves to keep constexpr depth logarithmic.
+constexpr std::size_t id_key(std::size_t id, std::size_t m)
+{
+	return m ? id % m : id;
+}
+
+// any j in [lo, hi) with key of ids[j] equal to key of ids[i]
+constexpr bool id_collides(const std::size_t *ids, std::size_t m, std::size_t i, std::size_t lo, std::size_t hi)
+{
+	return hi - lo == 0 ? false :
+		hi - lo == 1 ? id_key(ids[lo], m) == id_key(ids[i], m) :
+		id_collides(ids, m, i, lo, lo + (hi - lo) / 2) || id_collides(ids, m, i, lo + (hi - lo) / 2, hi);
+}
+
+// key of no ids[i], i in [lo, hi), is equal to key of any later ID
+constexpr bool ids_distinct(const std::size_t *ids, std::size_t n, std::size_t m, std::size_t lo, std::size_t hi)
+{
+	return hi - lo == 0 ? true :
+		hi - lo == 1 ? !id_collides(ids, m, lo, lo + 1, n) :
+		ids_distinct(ids, n, m, lo, lo + (hi - lo) / 2) && ids_distinct(ids, n, m, lo + (hi - lo) / 2, hi);
+}
+
+// first modulus in [lo, hi) separating all IDs, 0 if there is none
+constexpr std::size_t find_modulus(const std::size_t *ids, std::size_t n, std::size_t lo, std::size_t hi);
+
+constexpr std::size_t find_modulus_or(std::size_t found, const std::size_t *ids, std::size_t n, std::size_t lo, std::size_t hi)
+{
+	return found ? found : find_modulus(ids, n, lo, hi);
+}
+
+constexpr std::size_t find_modulus(const std::size_t *ids, std::size_t n, std::size_t lo, std::size_t hi)
+{
+	return hi - lo == 0 ? 0 :
+		hi - lo == 1 ? (ids_distinct(ids, n, lo, 0, n) ? lo : 0) :
+		find_modulus_or(find_modulus(ids, n, lo, lo + (hi - lo) / 2), ids, n, lo + (hi - lo) / 2, hi);
+}
+
+// index of state which ID has given key, n if there is none
+constexpr std::size_t id_slot(const std::size_t *ids, std::size_t n, std::size_t m, std::size_t key, std::size_t lo, std::size_t hi);
+
+constexpr std::size_t id_slot_or(std::size_t found, const std::size_t *ids, std::size_t n, std::size_t m, std::size_t key, std::size_t lo, std::size_t hi)
+{
+	return found != n ? found : id_slot(ids, n, m, key, lo, hi);
+}
+
+constexpr std::size_t id_slot(const std::size_t *ids, std::size_t n, std::size_t m, std::size_t key, std::size_t lo, std::size_t hi)
+{
+	return hi - lo == 0 ? n :
+		hi - lo == 1 ? (id_key(ids[lo], m) == key ? lo : n) :
+		id_slot_or(id_slot(ids, n, m, key, lo, lo + (hi - lo) / 2), ids, n, m, key, lo + (hi - lo) / 2, hi);
+}
+
+template<typename States, typename Index, typename Slots> struct state_id_map_impl;
+
+template<typename... States, typename Index, std::size_t... Ss>
+struct state_id_map_impl<std::tuple<States...>, Index, meta::index_sequence<Ss...>>
+{
+	using ids = state_ids<std::tuple<States...>>;
+
+	static constexpr std::size_t modulus = sizeof...(Ss);
+
+	// state index for every key, number of states for unused slots
+	static constexpr Index value[] = {
+		static_cast<Index>(id_slot(ids::value, sizeof...(States), modulus, Ss, 0, sizeof...(States)))...
+	};
+
+	// index of state with given ID, number of states if there is none
+	static Index find(std::size_t id)
+	{
+		const Index i = value[id % modulus];
+		return ids::value[i] == id ? i : static_cast<Index>(sizeof...(States));
+	}
+};
+
+template<typename... States, typename Index, std::size_t... Ss>
+constexpr Index state_id_map_impl<std::tuple<States...>, Index, meta::index_sequence<Ss...>>::value[];
+
+// IDs too sparse for any modulus in searched range, these are looked up
+// by a linear scan
+template<typename... States, typename Index>
+struct state_id_map_impl<std::tuple<States...>, Index, meta::index_sequence<>>
+{
+	using ids = state_ids<std::tuple<States...>>;
+
+	static Index find(std::size_t id)
+	{
+		Index i = 0;
+
+		while (i < sizeof...(States) && ids::value[i] != id) {
+			++i;
+		}
+
+		return i;
+	}
+};
+
+template<typename States, typename Index>
+struct state_id_map_check
+{
+	using ids = state_ids<States>;
+	static constexpr std::size_t n = std::tuple_size<States>::value;
+
+	static_assert(ids_distinct(ids::value, n, 0, 0, n),
+		"state IDs have to be unique to look states up by ID");
+
+	// table at most this many times larger than number of states
+	static constexpr std::size_t max_modulus = 8 * n + 64;
+
+	using type = state_id_map_impl<States, Index,
+		meta::make_index_sequence<find_modulus(ids::value, n, n ? n : 1, max_modulus)>>;
+};
+
+// O(1) map from fsm::state<ID> value to state index
+template<typename States, typename Index>
+using state_id_map = typename state_id_map_check<States, Index>::type;
+
+// insert I into list sorted by descending weight, I goes after all
+// elements of equal weight so declaration order is kept
+template<typename L, typename I, typename W> struct insert_by_weight;
+
+template<typename I, typename W>
+struct insert_by_weight<meta::list<>, I, W>
+{
+	using type = meta::list<std::pair<I, W>>;
+};
+
+template<typename I1, typename W1, typename... Ts, typename I, typename W>
+struct insert_by_weight<meta::list<std::pair<I1, W1>, Ts...>, I, W>
+{
+	using type = typename std::conditional<
+		(W::value > W1::value),
+		meta::list<std::pair<I, W>, std::pair<I1, W1>, Ts...>,
+		meta::push_front<
+			typename insert_by_weight<meta::list<Ts...>, I, W>::type,
+			std::pair<I1, W1>>
+	>::type;
+};
+
+} // namespace detail
+
+// defines one transition between two states, this is type triple:
+// StartState, Event trigger, StopState. Optional Guard is a default
+// constructible functor with bool operator()(const E &) const or, given
+// the context of the machine, bool operator()(Context &, const E &) const.
+// Guarded transitions of the same state and event are alternatives tried
+// in declaration order, the first one whose guard passes is taken and the
+// last one may be left unguarded as a fallback.
+// Optional Action is a functor of the same kind returning void, it runs
+// after exit() of StartState and before enter() of StopState. Guards and
+// actions are created on every call, they can't have any data members.
+template<typename S1, typename E, typename S2, typename Guard = void, typename Action = void>
+struct transition
+{
+	using start_t = S1;
+	using stop_t = S2;
+	using event_t = E;
+	using guard_t = Guard;
+	using action_t = Action;
+
+	// how often transition is taken, zero for not profiled (cold) ones
+	using weight = std::integral_constant<std::size_t, 0>;
+
+	// transition leaves its start state, even if it stops in the same one
+	using is_internal = std::false_type;
+};
+
+// event E handled by state S without leaving it, only event() of S is
+// called. Unlike transition<S, E, S>, which runs exit() and enter() of S
+// again, the hooks are skipped and the current state is not stored. Guard
+// and Action are the same as for fsm::transition, Action runs after event().
+template<typename S, typename E, typename Guard = void, typename Action = void>
+struct internal : public transition<S, E, S, Guard, Action>
+{
+	using is_internal = std::true_type;
+};
+
+// marks transition T as frequently taken (hot), states of hot transitions
+// are checked first when dispatching an event. Weight orders hot transitions
+// of the same event, use counts from an instrumented build here.
+template<typename T, std::size_t Weight = 1>
+struct hot : public T
+{
+	static_assert(Weight > 0, "hot transition needs positive weight");
+
+	using weight = std::integral_constant<std::size_t, Weight>;
+};
+
+// when State is entered a timer is armed, if the state is still current
+// after Duration (std::ratio of seconds) Event is sent to the machine.
+// State needs a regular transition triggered by Event. Timeouts are
+// handled by fsm::timed_fsm from fsm/timer.hpp.
+template<typename State, typename Duration, typename Event>
+struct timeout
+{
+	using state_t = State;
+	using duration_t = Duration;
+	using event_t = Event;
+};
+
+// selects initial state of the machine, without it the start state of
+// the first transition is the initial one
+template<typename State>
+struct initial
+{
+	using state_t = State;
+};
+
+// order of states in generated transition tables, the first one is the
+// initial state selected by fsm::initial as well. Tables with this entry
+// have every transition wrapped in fsm::indexed and sorted by event and
+// then by start index, so state indices don't have to be derived. They
+// are meant to be emitted by tools/fsm-gen rather than written by hand.
+template<typename... States>
+struct state_order
+{
+	using states = meta::list<States...>;
+};
+
+// transition T with precomputed indices of its start and stop states
+template<typename T, std::size_t From, std::size_t To>
+struct indexed : public T
+{
+	using start_index = std::integral_constant<std::size_t, From>;
+	using stop_index = std::integral_constant<std::size_t, To>;
+};
+
+template<std::intmax_t N>
+using seconds = std::ratio<N>;
+
+template<std::intmax_t N>
+using milliseconds = std::ratio<N, 1000>;
+
+namespace detail
+{
+
+template<typename T>
+struct is_timeout : public std::false_type {};
+
+template<typename S, typename D, typename E>
+struct is_timeout<timeout<S, D, E>> : public std::true_type {};
+
+template<typename T>
+struct is_initial : public std::false_type {};
+
+template<typename S>
+struct is_initial<initial<S>> : public std::true_type {};
+
+template<typename T>
+struct is_state_order : public std::false_type {};
+
+template<typename... Ss>
+struct is_state_order<state_order<Ss...>> : public std::true_type {};
+
+template<typename T>
+struct is_indexed : public std::false_type {};
+
+template<typename T, std::size_t From, std::size_t To>
+struct is_indexed<indexed<T, From, To>> : public std::true_type {};
+
+// T without precomputed indices
+template<typename T>
+struct plain_transition
+{
+	using type = T;
+};
+
+template<typename T, std::size_t From, std::size_t To>
+struct plain_transition<indexed<T, From, To>>
+{
+	using type = T;
+};
+
+struct plain_transition_func {
+	template<typename T>
+	using invoke = typename plain_transition<T>::type;
+};
+
+struct is_guarded_selector {
+	template<typename T>
+	using invoke = meta::not_<std::is_void<typename T::guard_t>>;
+};
+
+struct has_action_selector {
+	template<typename T>
+	using invoke = meta::not_<std::is_void<typename T::action_t>>;
+};
+
+// evaluates guard G of a transition, with the context if G takes one and
+// the machine has it, transitions without guard always pass
+template<typename G>
+struct guard
+{
+	template<typename Ctx, typename E,
+		typename = typename std::enable_if<!std::is_same<Ctx, null_context>::value>::type>
+	static auto check(Ctx *ctx, const E &e, int) noexcept(noexcept(G{}(*ctx, e)))
+		-> decltype(bool(G{}(*ctx, e)))
+	{
+		return G{}(*ctx, e);
+	}
+
+	template<typename Ctx, typename E>
+	static auto check(Ctx *, const E &e, long) noexcept(noexcept(G{}(e)))
+		-> decltype(bool(G{}(e)))
+	{
+		return G{}(e);
+	}
+};
+
+template<>
+struct guard<void>
+{
+	template<typename Ctx, typename E>
+	static constexpr bool check(Ctx *, const E &, int) noexcept
+	{
+		return true;
+	}
+};
+
+// runs action A of a transition, the same way guards are called
+template<typename A>
+struct action
+{
+	template<typename Ctx, typename E,
+		typename = typename std::enable_if<!std::is_same<Ctx, null_context>::value>::type>
+	static auto run(Ctx *ctx, const E &e, int) noexcept(noexcept(A{}(*ctx, e)))
+		-> decltype(void(A{}(*ctx, e)))
+	{
+		A{}(*ctx, e);
+	}
+
+	template<typename Ctx, typename E>
+	static auto run(Ctx *, const E &e, long) noexcept(noexcept(A{}(e)))
+		-> decltype(void(A{}(e)))
+	{
+		A{}(e);
+	}
+};
+
+template<>
+struct action<void>
+{
+	template<typename Ctx, typename E>
+	static void run(Ctx *, const E &, int) noexcept
+	{
+	}
+};
+
+// guard or action F of transition triggered by E wants context Ctx
+template<typename F, typename Ctx, typename E, typename = void>
+struct takes_context : public std::false_type {};
+
+template<typename F, typename Ctx, typename E>
+struct takes_context<F, Ctx, E,
+	typename make_void<decltype(F{}(std::declval<Ctx &>(), std::declval<const E &>()))>::type> :
+	public std::true_type
+{
+};
+
+template<typename Ctx>
+struct functor_context_selector {
+	template<typename T>
+	using invoke = meta::bool_<!std::is_same<Ctx, null_context>::value &&
+		(takes_context<typename T::guard_t, Ctx, typename T::event_t>::value ||
+		takes_context<typename T::action_t, Ctx, typename T::event_t>::value)>;
+};
+
+// some guard or action of table Trs takes the context, the machine keeps
+// a pointer to it then
+template<typename Trs, typename Ctx, bool = Trs::guarded::value || Trs::has_actions::value>
+struct keeps_functor_context : public meta::not_<meta::empty<
+	meta::filter<typename Trs::list, functor_context_selector<Ctx>>>>
+{
+};
+
+template<typename Trs, typename Ctx>
+struct keeps_functor_context<Trs, Ctx, false> : public std::false_type {};
+
+// all of several alternatives but the last one have guards
+template<typename Alternatives>
+struct guarded_alternatives : public std::true_type {};
+
+template<typename A, typename B, typename... As>
+struct guarded_alternatives<meta::list<A, B, As...>> : public meta::bool_<
+	!std::is_void<typename A::type::guard_t>::value &&
+	guarded_alternatives<meta::list<B, As...>>::value>
+{
+};
+
+// states in order of their indices, given by state_order if there is one
+template<typename Orders, typename Initials, typename Starts, typename Stops>
+struct unique_states_impl
+{
+	using type = meta::unique<meta::concat<Initials, Starts, Stops>>;
+};
+
+template<typename Order, typename Initials, typename Starts, typename Stops>
+struct unique_states_impl<meta::list<Order>, Initials, Starts, Stops>
+{
+	using type = typename Order::states;
+};
+
+struct initial_state_selector {
+	template<typename T>
+	using invoke = typename T::state_t;
+};
+
+template<typename L>
+struct starts_in_selector {
+	template<typename T>
+	using invoke = meta::in<L, typename T::start_t>;
+};
+
+template<typename L>
+struct timeout_in_selector {
+	template<typename T>
+	using invoke = meta::in<L, typename T::state_t>;
+};
+
+// reachability works on state indices, reached states are kept as bits
+// of 64 bit words so a search step is a single constant expression per
+// word instead of type list operations per state
+template<std::uint64_t... Ws>
+struct reached_words
+{
+	static constexpr std::uint64_t value[] = {Ws..., 0};
+};
+
+template<std::uint64_t... Ws>
+constexpr std::uint64_t reached_words<Ws...>::value[];
+
+constexpr bool is_reached(const std::uint64_t *reached, std::size_t i)
+{
+	return (reached[i / 64] >> (i % 64)) & 1;
+}
+
+// bits of word W set for stop states of transitions [lo, hi) starting in
+// a reached state
+constexpr std::uint64_t reached_bits(const std::uint64_t *reached,
+	const std::size_t *from, const std::size_t *to, std::size_t w, std::size_t lo, std::size_t hi)
+{
+	return hi - lo == 0 ? 0 :
+		hi - lo == 1 ?
+			(to[lo] / 64 == w && is_reached(reached, from[lo]) ? std::uint64_t(1) << (to[lo] % 64) : 0) :
+		reached_bits(reached, from, to, w, lo, lo + (hi - lo) / 2) |
+		reached_bits(reached, from, to, w, lo + (hi - lo) / 2, hi);
+}
+
+constexpr bool strictly_increasing()
+{
+	return true;
+}
+
+constexpr bool strictly_increasing(std::size_t)
+{
+	return true;
+}
+
+// every index is greater than the one before it
+template<typename... Is>
+constexpr bool strictly_increasing(std::size_t a, std::size_t b, Is... rest)
+{
+	return a < b && strictly_increasing(b, rest...);
+}
+
+// indices of start and stop states of transitions in List, leading
+// entries keep arrays of empty tables valid and start in no state
+template<typename States, typename List> struct edge_indices;
+
+template<typename States, typename... Ts>
+struct edge_indices<States, meta::list<Ts...>>
+{
+	static constexpr std::size_t count = sizeof...(Ts) + 1;
+	static constexpr std::size_t from[] = {States::size(), meta::find_index<States, typename Ts::start_t>::value...};
+	static constexpr std::size_t to[] = {0, meta::find_index<States, typename Ts::stop_t>::value...};
+};
+
+template<typename States, typename... Ts>
+constexpr std::size_t edge_indices<States, meta::list<Ts...>>::from[];
+
+template<typename States, typename... Ts>
+constexpr std::size_t edge_indices<States, meta::list<Ts...>>::to[];
+
+// extends Reached by stop states of transitions starting in Reached
+// until nothing new is found
+template<typename Edges, typename Words, typename Reached, bool Done = false>
+struct reachable_impl;
+
+template<typename Edges, std::size_t... Is, std::uint64_t... Ws>
+struct reachable_impl<Edges, meta::index_sequence<Is...>, reached_words<Ws...>, false>
+{
+	using next = reached_words<(Ws |
+		reached_bits(reached_words<Ws...>::value, Edges::from, Edges::to, Is, 0, Edges::count))...>;
+
+	using type = typename reachable_impl<Edges, meta::index_sequence<Is...>, next,
+		std::is_same<next, reached_words<Ws...>>::value>::type;
+};
+
+template<typename Edges, typename Words, typename Reached>
+struct reachable_impl<Edges, Words, Reached, true>
+{
+	using type = Reached;
+};
+
+template<typename States, typename Reached, typename Is> struct reached_states;
+
+template<typename... States, typename Reached, std::size_t... Is>
+struct reached_states<meta::list<States...>, Reached, meta::index_sequence<Is...>> :
+	public meta::detail::concat<meta::if_<
+		meta::bool_<is_reached(Reached::value, Is)>,
+		meta::list<States>,
+		meta::list<>>...>
+{
+};
+
+template<typename States, typename List, typename Words> struct reachable_from_first;
+
+template<typename States, typename List, std::size_t... Is>
+struct reachable_from_first<States, List, meta::index_sequence<Is...>> :
+	public reached_states<
+		States,
+		typename reachable_impl<
+			edge_indices<States, List>,
+			meta::index_sequence<Is...>,
+			reached_words<(Is == 0 ? 1 : 0)...>>::type,
+		meta::make_index_sequence<States::size()>>
+{
+};
+
+// states of States reachable from the first one through transitions in List
+template<typename States, typename List>
+using reachable = typename reachable_from_first<
+	States, List, meta::make_index_sequence<(States::size() + 63) / 64>>::type;
+
+} // namespace detail
+
+template<typename... Ts>
+struct transitions
+{
+	struct is_timeout_selector {
+		template<typename T>
+		using invoke = detail::is_timeout<T>;
+	};
+
+	struct is_initial_selector {
+		template<typename T>
+		using invoke = detail::is_initial<T>;
+	};
+
+	struct is_state_order_selector {
+		template<typename T>
+		using invoke = detail::is_state_order<T>;
+	};
+
+	struct is_transition_selector {
+		template<typename T>
+		using invoke = meta::not_<meta::or_<
+			detail::is_timeout<T>,
+			detail::is_initial<T>,
+			detail::is_state_order<T>>>;
+	};
+
+	struct is_indexed_selector {
+		template<typename T>
+		using invoke = detail::is_indexed<T>;
+	};
+
+	// all entries of transition table split by their kind
+	using list = meta::filter<meta::list<Ts...>, is_transition_selector>;
+	using timeouts = meta::filter<meta::list<Ts...>, is_timeout_selector>;
+	using initial_entries = meta::filter<meta::list<Ts...>, is_initial_selector>;
+	using state_order_entries = meta::filter<meta::list<Ts...>, is_state_order_selector>;
+
+	// generated table with precomputed state indices
+	using precomputed = meta::not_<meta::empty<state_order_entries>>;
+
+	// some transitions have guards or actions, see fsm::transition
+	using guarded = meta::not_<meta::empty<meta::filter<list, detail::is_guarded_selector>>>;
+	using has_actions = meta::not_<meta::empty<meta::filter<list, detail::has_action_selector>>>;
+
+	static_assert(initial_entries::size() <= 1, "only one initial state can be selected");
+	static_assert(state_order_entries::size() <= 1, "only one state order can be given");
+	static_assert(!precomputed::value ||
+		meta::filter<list, is_indexed_selector>::size() == list::size(),
+		"all transitions of a table with state order have to be indexed");
+	static_assert(!precomputed::value || initial_entries::size() == 1,
+		"table with state order needs its initial state selected by fsm::initial");
+	static_assert(!precomputed::value || !guarded::value,
+		"generated tables can't have guarded transitions");
+
+	struct start_states_selector {
+		template<typename T>
+		using invoke = typename T::start_t;
+	};
+
+	struct stop_states_selector {
+		template<typename T>
+		using invoke = typename T::stop_t;
+	};
+
+	using start_states = meta::transform<list, start_states_selector>;
+	using stop_states = meta::transform<list, stop_states_selector>;
+	// initial state always gets index 0
+	using unique_states = typename detail::unique_states_impl<
+		state_order_entries,
+		meta::transform<initial_entries, detail::initial_state_selector>,
+		start_states,
+		stop_states>::type;
+
+	using states_tuple_t = meta::apply<meta::quote<std::tuple>, unique_states>;
+	using states_count = std::tuple_size<states_tuple_t>;
+
+	struct state_events_func {
+		template<typename T>
+		using invoke = meta::list<typename T::start_t, typename T::event_t>;
+	};
+
+	// create list of lists. This is StartState, Event extract from transitions
+	using state_events = meta::transform<list, state_events_func>;
+
+	struct events_selector {
+		template<typename T>
+		using invoke = typename T::event_t;
+	};
+
+	// all event types triggering any transition
+	using events = meta::unique<meta::transform<list, events_selector>>;
+
+	// states reachable from the initial state (index 0)
+	using reachable_states = detail::reachable<unique_states, list>;
+
+	struct unreachable_selector {
+		template<typename S>
+		using invoke = meta::not_<meta::in<reachable_states, S>>;
+	};
+
+	using unreachable_states = meta::filter<unique_states, unreachable_selector>;
+	using all_reachable = meta::empty<unreachable_states>;
+};
+
+// transition table Trs without states unreachable from its initial state,
+// transitions and timeouts of these states are dropped as well. Indices
+// precomputed by fsm::indexed are dropped too, they don't hold any more.
+template<typename Trs>
+using prune_unreachable = meta::apply<
+	meta::quote<transitions>,
+	meta::concat<
+		meta::transform<
+			meta::filter<typename Trs::list, detail::starts_in_selector<typename Trs::reachable_states>>,
+			detail::plain_transition_func>,
+		meta::filter<typename Trs::timeouts, detail::timeout_in_selector<typename Trs::reachable_states>>,
+		typename Trs::initial_entries>>;
+
+namespace detail
+{
+
+// warns at compile time when machine is created from a table with dead
+// entries, define FSM_NO_REACHABILITY_WARNING to silence it
+template<bool AllReachable>
+struct reachability_check
+{
+	static void check() {}
+};
+
+#if !defined(FSM_NO_REACHABILITY_WARNING)
+template<>
+struct reachability_check<false>
+{
+	FSM_DEPRECATED("transition table has states unreachable from the initial state, "
+		"see transitions::unreachable_states or use fsm::prune_unreachable")
+	static void check() {}
+};
+#endif
+
+} // namespace detail
+
+namespace detail
+{
+
+#if __cplusplus >= 201402L
+template<typename T>
+using is_final = std::is_final<T>;
+#else
+template<typename T>
+using is_final = std::integral_constant<bool, __is_final(T)>;
+#endif
+
+// empty states are stored as base classes so they do not take any space
+// (empty base optimization), final classes can't be derived from
+template<typename S>
+using is_compressible = std::integral_constant<bool,
+	std::is_empty<S>::value && !is_final<S>::value>;
+
+// storage of single state instance, I makes every leaf a distinct type
+// even if the same state type would be stored twice
+template<std::size_t I, typename S, bool = is_compressible<S>::value>
+struct state_leaf
+{
+	state_leaf() = default;
+
+	template<typename Ctx>
+	state_leaf(Ctx &ctx, std::true_type) :
+		state (ctx)
+	{
+	}
+
+	template<typename Ctx>
+	state_leaf(Ctx &, std::false_type) :
+		state ()
+	{
+	}
+
+	S &get() { return state; }
+
+	S state;
+};
+
+template<std::size_t I, typename S>
+struct state_leaf<I, S, true> : public S
+{
+	state_leaf() = default;
+
+	template<typename Ctx>
+	state_leaf(Ctx &ctx, std::true_type) :
+		S (ctx)
+	{
+	}
+
+	template<typename Ctx>
+	state_leaf(Ctx &, std::false_type) :
+		S ()
+	{
+	}
+
+	S &get() { return *this; }
+};
+
+template<typename, typename...> struct state_storage;
+
+template<std::size_t... Is, typename... States>
+struct state_storage<meta::index_sequence<Is...>, States...> : public state_leaf<Is, States>...
+{
+	state_storage() = default;
+
+	// states not constructible from the context are default constructed
+	template<typename Ctx>
+	explicit state_storage(Ctx &ctx) :
+		state_leaf<Is, States> (ctx, std::is_constructible<States, Ctx &>{})...
+	{
+	}
+};
+
+// access I-th state, S is deduced from the matching base class
+template<std::size_t I, typename S, bool B>
+S &get_state(state_leaf<I, S, B> &leaf)
+{
+	return leaf.get();
+}
+
+} // namespace detail
+
+// instances of all states, the states are not kept in std::tuple as it
+// does not guarantee that empty states take no space
+template<typename, typename = detail::null_context> struct state_instances;
+
+template<typename... States, typename Ctx>
+struct state_instances<std::tuple<States...>, Ctx> :
+	public detail::state_storage<meta::make_index_sequence<sizeof...(States)>, States...>
+{
+	using storage_t = detail::state_storage<meta::make_index_sequence<sizeof...(States)>, States...>;
+
+	// true if every state is stored as an empty base
+	using all_compressed = meta::and_<detail::is_compressible<States>...>;
+
+	state_instances() = default;
+
+	state_instances(Ctx &ctx) :
+		storage_t (ctx)
+	{
+	}
+};
+
+// base of every state, ID is reported by currentState()
+template<std::size_t ID>
+struct state : public std::integral_constant<std::size_t, ID> {
+};
+
+// base of states without behavior of their own, e.g. with all of it in
+// transition actions. Hooks here do nothing and every event is accepted,
+// hooks the state declares itself hide them.
+template<std::size_t ID>
+struct empty_state : public state<ID> {
+	void enter() noexcept {}
+	void exit() noexcept {}
+
+	template<typename E>
+	bool event(const E &) noexcept { return true; }
+
+	// hooks of flyweight states
+	template<typename Ctx>
+	void enter(Ctx &) noexcept {}
+
+	template<typename Ctx>
+	void exit(Ctx &) noexcept {}
+
+	template<typename Ctx, typename E>
+	bool event(Ctx &, const E &) noexcept { return true; }
+};
+
+// machine constructed with this tag doesn't enter its initial state
+// until start() is called
+struct lazy_start_t {};
+constexpr lazy_start_t lazy_start {};
+
+// Context wrapper selecting flyweight states. The machine keeps its own
+// Context and no state objects, states have to be empty and their hooks
+// receive the context: enter(Ctx &), exit(Ctx &) and event(Ctx &, const E &).
+// State instances are then shared by all machines of the same type.
+template<typename Ctx>
+struct flyweight
+{
+	using context_t = Ctx;
+};
+
+namespace detail
+{
+
+// context given to guards and actions. States keep their own reference
+// to it, so the machine stores one only if some of them take the context.
+template<typename Context, bool Keep>
+struct functor_context
+{
+	functor_context() = default;
+
+	explicit functor_context(Context &)
+	{
+	}
+
+	Context *functorContext() noexcept
+	{
+		return nullptr;
+	}
+};
+
+template<typename Context>
+struct functor_context<Context, true>
+{
+	functor_context() :
+		ctx (nullptr)
+	{
+	}
+
+	explicit functor_context(Context &c) :
+		ctx (&c)
+	{
+	}
+
+	Context *functorContext() noexcept
+	{
+		return ctx;
+	}
+
+	Context *ctx;
+};
+
+// per machine data: state objects and index of current state, empty
+// states are base classes here so they share storage with the index
+template<typename States, typename Context, typename Index, bool KeepContext = false>
+struct machine_data : public state_instances<States, Context>, public functor_context<Context, KeepContext>
+{
+	using instances_t = state_instances<States, Context>;
+	using functor_context_t = functor_context<Context, KeepContext>;
+	using context_t = Context;
+	using ctor_arg_t = Context &;
+	using all_compressed = typename instances_t::all_compressed;
+	using keeps_context = meta::bool_<KeepContext>;
+
+	// index of a machine which was not started yet
+	static constexpr Index not_started = std::tuple_size<States>::value;
+
+	machine_data() :
+		current (not_started)
+	{
+	}
+
+	machine_data(Context &ctx) :
+		instances_t (ctx),
+		functor_context_t (ctx),
+		current (not_started)
+	{
+	}
+
+	template<std::size_t I>
+	using state_t = typename std::tuple_element<I, States>::type;
+
+	// hooks return whatever the state returns, asynchronous machines
+	// accept awaitable results here
+	template<std::size_t I>
+	auto enter() noexcept(noexcept(std::declval<state_t<I> &>().enter()))
+		-> decltype(std::declval<state_t<I> &>().enter())
+	{
+		return get_state<I>(*this).enter();
+	}
+
+	template<std::size_t I>
+	auto exit() noexcept(noexcept(std::declval<state_t<I> &>().exit()))
+		-> decltype(std::declval<state_t<I> &>().exit())
+	{
+		return get_state<I>(*this).exit();
+	}
+
+	template<std::size_t I, typename E>
+	auto event(const E &e) noexcept(noexcept(std::declval<state_t<I> &>().event(e)))
+		-> decltype(std::declval<state_t<I> &>().event(e))
+	{
+		return get_state<I>(*this).event(e);
+	}
+
+	Index current;
+};
+
+// flyweight machine data: the context and index of current state, states
+// are created on demand, which is free as they are required to be empty
+template<typename... States, typename Ctx, typename Index, bool KeepContext>
+struct machine_data<std::tuple<States...>, flyweight<Ctx>, Index, KeepContext>
+{
+	static_assert(
+		meta::and_<std::is_empty<States>...>::value,
+		"flyweight states can't have any data members, keep it in the context");
+
+	using context_t = Ctx;
+	using ctor_arg_t = const Ctx &;
+	using all_compressed = std::false_type;
+	using keeps_context = std::false_type;
+
+	template<std::size_t I>
+	using state_t = typename std::tuple_element<I, std::tuple<States...>>::type;
+
+	static constexpr Index not_started = sizeof...(States);
+
+	machine_data() :
+		context (),
+		current (not_started)
+	{
+	}
+
+	machine_data(const Ctx &ctx) :
+		context (ctx),
+		current (not_started)
+	{
+	}
+
+	template<std::size_t I>
+	auto enter() noexcept(noexcept(state_t<I>{}.enter(std::declval<Ctx &>())))
+		-> decltype(std::declval<state_t<I> &>().enter(std::declval<Ctx &>()))
+	{
+		return state_t<I>{}.enter(context);
+	}
+
+	template<std::size_t I>
+	auto exit() noexcept(noexcept(state_t<I>{}.exit(std::declval<Ctx &>())))
+		-> decltype(std::declval<state_t<I> &>().exit(std::declval<Ctx &>()))
+	{
+		return state_t<I>{}.exit(context);
+	}
+
+	template<std::size_t I, typename E>
+	auto event(const E &e) noexcept(noexcept(state_t<I>{}.event(std::declval<Ctx &>(), e)))
+		-> decltype(std::declval<state_t<I> &>().event(std::declval<Ctx &>(), e))
+	{
+		return state_t<I>{}.event(context, e);
+	}
+
+	Ctx *functorContext() noexcept
+	{
+		return &context;
+	}
+
+	Ctx context;
+	Index current;
+};
+
+} // namespace detail
+
+namespace detail
+{
+
+// compile time properties of transition table used by state machines
+template<typename Trs>
+struct table
+{
+	using Transitions = Trs;
+
+	// count all (S[tartState], E[vent]) pairs in provided list
+	// this one is needed to determine if specified state S is handling event E
+	template<typename S, typename E>
+	using handle_event = meta::count<
+		typename Transitions::state_events,
+		meta::list<S, E>>;
+
+	// meta-function for checking if provided T (struct transition) has the same S[tate] and E[vent]
+	// as provided in template arguments
+	template<typename S, typename E>
+	struct check_dest {
+		template<typename T>
+		using invoke = meta::and_<std::is_same<S, typename T::start_t>, std::is_same<E, typename T::event_t>>;
+	};
+
+	// selecting transition matching StartState-Event criteria
+	template<typename S, typename E>
+	using destination = meta::front<meta::find_if<typename Transitions::list, check_dest<S, E>>>;
+
+	// determining stop state from StartState, Event pair
+	template<typename S, typename E>
+	using destination_state = typename destination<S, E>::stop_t;
+
+	template<typename I>
+	using index_to_state = typename std::tuple_element<I::value, typename Transitions::states_tuple_t>::type;
+
+	template<typename I, typename E>
+	using next_state = destination_state<index_to_state<I>, E>;
+
+	template<typename T>
+	using state_to_index = meta::find_index<typename Transitions::unique_states, T>;
+
+	template<typename E>
+	struct has_event {
+		template<typename T>
+		using invoke = std::is_same<E, typename T::event_t>;
+	};
+
+	struct start_index_func {
+		template<typename T>
+		using invoke = state_to_index<typename T::start_t>;
+	};
+
+	// transitions triggered by E and indices of their start states, these
+	// are computed once per event and shared by lookups of all states
+	template<typename E>
+	using event_transitions = meta::filter<typename Transitions::list, has_event<E>>;
+
+	template<typename E>
+	using event_start_indices = meta::transform<event_transitions<E>, start_index_func>;
+
+	// candidates of generated tables carry their transition, others have
+	// to search for it
+	template<typename I, typename E, typename = void>
+	struct candidate_transition
+	{
+		using type = meta::at<event_transitions<E>, meta::find_index<event_start_indices<E>, I>>;
+		using stop_index = state_to_index<typename type::stop_t>;
+		using unique = meta::bool_<meta::count<event_start_indices<E>, I>::value == 1>;
+	};
+
+	template<typename I, typename E>
+	struct candidate_transition<I, E, typename make_void<typename I::transition_t>::type>
+	{
+		using type = typename I::transition_t;
+		using stop_index = typename type::stop_index;
+		using unique = std::true_type;
+	};
+
+	template<typename I, typename E>
+	using next_state_index = typename candidate_transition<I, E>::stop_index;
+
+	// only one transition from state I is triggered by event E
+	template<typename I, typename E>
+	using unique_transition = typename candidate_transition<I, E>::unique;
+
+	template<typename I>
+	struct starts_at {
+		template<typename T>
+		using invoke = meta::bool_<state_to_index<typename T::start_t>::value == I::value>;
+	};
+
+	template<typename T>
+	struct alternative
+	{
+		using type = T;
+		using stop_index = state_to_index<typename T::stop_t>;
+	};
+
+	struct alternative_func {
+		template<typename T>
+		using invoke = alternative<T>;
+	};
+
+	template<typename I, typename E, bool = unique_transition<I, E>::value>
+	struct alternatives_impl
+	{
+		using type = meta::list<candidate_transition<I, E>>;
+	};
+
+	template<typename I, typename E>
+	struct alternatives_impl<I, E, false>
+	{
+		using type = meta::transform<meta::filter<event_transitions<E>, starts_at<I>>, alternative_func>;
+	};
+
+	// transitions from state I triggered by E in declaration order, each
+	// with type and stop_index of its transition. Several of them have to
+	// be told apart by guards.
+	template<typename I, typename E>
+	using alternatives = typename alternatives_impl<I, E>::type;
+
+	template<typename E>
+	struct handles_event {
+		template<typename I>
+		using invoke = meta::in<event_start_indices<E>, I>;
+	};
+
+	// start index of generated transition, with the transition attached
+	template<typename T>
+	struct indexed_candidate : public T::start_index
+	{
+		using transition_t = T;
+	};
+
+	struct indexed_candidate_func {
+		template<typename T>
+		using invoke = indexed_candidate<T>;
+	};
+
+	// precomputed indices of generated transitions Ts agree with the state
+	// order and each state appears once among the starts. This searches
+	// the state order for every transition, so it is only done with
+	// FSM_CHECK_INDEXED, tables emitted by tools/fsm-gen are trusted.
+	template<typename List> struct indexed_checks;
+
+	template<typename... Ts>
+	struct indexed_checks<meta::list<Ts...>>
+	{
+		using indices_match = meta::and_<meta::bool_<
+			Ts::start_index::value == state_to_index<typename Ts::start_t>::value &&
+			Ts::stop_index::value == state_to_index<typename Ts::stop_t>::value>...>;
+
+		using sorted = meta::bool_<detail::strictly_increasing(Ts::start_index::value...)>;
+	};
+
+	template<typename E, bool = Transitions::precomputed::value>
+	struct candidates_impl
+	{
+		using type = meta::filter<
+			index_list<Transitions::states_count::value>,
+			handles_event<E>>;
+	};
+
+	// generated tables are already sorted by start index
+	template<typename E>
+	struct candidates_impl<E, true>
+	{
+#if defined(FSM_CHECK_INDEXED)
+		static_assert(indexed_checks<event_transitions<E>>::indices_match::value,
+			"indices of fsm::indexed transitions have to match positions of their states in fsm::state_order");
+		static_assert(indexed_checks<event_transitions<E>>::sorted::value,
+			"fsm::indexed transitions of an event have to be sorted by start index, "
+			"one transition per start state");
+#endif
+
+		using type = meta::transform<event_transitions<E>, indexed_candidate_func>;
+	};
+
+	// sorted indices of states having a transition triggered by event E,
+	// only these states are visited when dispatching E
+	template<typename E>
+	using candidates = typename candidates_impl<E>::type;
+
+	// candidate lists longer than this are dispatched by binary search
+	static constexpr std::size_t linear_dispatch_limit = 4;
+
+	template<typename I, typename E>
+	using transition_weight = typename candidate_transition<I, E>::type::weight;
+
+	template<typename E>
+	struct is_hot {
+		template<typename I>
+		using invoke = meta::bool_<(transition_weight<I, E>::value > 0)>;
+	};
+
+	template<typename E>
+	struct is_cold {
+		template<typename I>
+		using invoke = meta::bool_<transition_weight<I, E>::value == 0>;
+	};
+
+	struct insert_hot_func {
+		template<typename L, typename P>
+		using invoke = typename insert_by_weight<L, typename P::first_type, typename P::second_type>::type;
+	};
+
+	template<typename E>
+	struct to_weighted_func {
+		template<typename I>
+		using invoke = std::pair<I, transition_weight<I, E>>;
+	};
+
+	struct from_weighted_func {
+		template<typename P>
+		using invoke = typename P::first_type;
+	};
+
+	// indices of states with hot transition on E, the most frequent first
+	template<typename E>
+	using hot_candidates = meta::transform<
+		meta::fold<
+			meta::transform<meta::filter<candidates<E>, is_hot<E>>, to_weighted_func<E>>,
+			meta::list<>,
+			insert_hot_func>,
+		from_weighted_func>;
+
+	// remaining candidates, still sorted by index
+	template<typename E>
+	using cold_candidates = meta::filter<candidates<E>, is_cold<E>>;
+
+	struct is_hot_transition {
+		template<typename T>
+		using invoke = meta::bool_<(T::weight::value > 0)>;
+	};
+
+	// with any hot transition in the table all the others are moved out of line
+	using has_hot = meta::not_<meta::empty<meta::filter<typename Transitions::list, is_hot_transition>>>;
+
+	// fsm::state<ID> value of state at given index
+	static std::size_t state_id(std::size_t index)
+	{
+		return state_ids<typename Transitions::states_tuple_t>::value[index];
+	}
+
+	// index of state with given fsm::state<ID> value, number of states
+	// if there is none
+	template<typename Index>
+	static Index state_index(std::size_t id)
+	{
+		return state_id_map<typename Transitions::states_tuple_t, Index>::find(id);
+	}
+};
+
+// bits of handled[lo, hi) shifted down by base, handled events of a
+// state are packed to 64 bit words by this
+constexpr std::uint64_t event_bits(const bool *handled, std::size_t lo, std::size_t hi, std::size_t base)
+{
+	return hi - lo == 0 ? 0 :
+		hi - lo == 1 ? (handled[lo] ? std::uint64_t(1) << (lo - base) : 0) :
+		event_bits(handled, lo, lo + (hi - lo) / 2, base) | event_bits(handled, lo + (hi - lo) / 2, hi, base);
+}
+
+// flags of Trs::events having a transition from state at index I
+template<typename Table, typename I, typename Events = typename Table::Transitions::events>
+struct handled_events;
+
+template<typename Table, typename I, typename... Es>
+struct handled_events<Table, I, meta::list<Es...>>
+{
+	static constexpr bool value[] = {meta::in<typename Table::template event_start_indices<Es>, I>::value..., false};
+};
+
+template<typename Table, typename I, typename... Es>
+constexpr bool handled_events<Table, I, meta::list<Es...>>::value[];
+
+template<typename Table>
+constexpr std::size_t event_mask_words()
+{
+	return (Table::Transitions::events::size() + 63) / 64;
+}
+
+// bitmask of handled events for every state index, bit K of word K / 64
+// stands for K-th event of Trs::events. Last row is for machine which
+// was not started yet and has no bits set.
+template<typename Table, typename Fs = meta::make_index_sequence<
+	(Table::Transitions::states_count::value + 1) * event_mask_words<Table>()>>
+struct event_masks;
+
+template<typename Table, std::size_t... Fs>
+struct event_masks<Table, meta::index_sequence<Fs...>>
+{
+	static constexpr std::size_t words = event_mask_words<Table>();
+	static constexpr std::size_t events = Table::Transitions::events::size();
+
+	template<std::size_t I, std::size_t W>
+	static constexpr std::uint64_t word()
+	{
+		return I == Table::Transitions::states_count::value ? 0 :
+			event_bits(handled_events<Table, meta::size_t<I>>::value,
+				W * 64, W * 64 + 64 < events ? W * 64 + 64 : events, W * 64);
+	}
+
+	static constexpr std::uint64_t value[] = {word<Fs / words, Fs % words>()..., 0};
+};
+
+template<typename Table, std::size_t... Fs>
+constexpr std::uint64_t event_masks<Table, meta::index_sequence<Fs...>>::value[];
+
+// tests bit of event E in mask of state at given index, events without
+// any transition are never handled
+template<typename Table, typename E,
+	std::size_t K = meta::find_index<typename Table::Transitions::events, E>::value>
+struct event_mask_test
+{
+	static bool test(std::size_t index)
+	{
+		using masks = event_masks<Table>;
+		return (masks::value[index * masks::words + K / 64] >> (K % 64)) & 1;
+	}
+};
+
+template<typename Table, typename E>
+struct event_mask_test<Table, E, meta::npos>
 {
-struct null_context {};
+	static bool test(std::size_t)
+	{
+		return false;
+	}
+};
+
+// observer of dispatch not interested in the transition taken, see
+// fsm::onObserved
+struct null_observer
+{
+	template<typename T>
+	void selected() noexcept {}
+};
+
+// finds current state among states handling event E and calls
+// f.template transit<I>() for it, I is index of the state
+template<typename Table, typename E>
+struct dispatcher
+{
+	template<typename F>
+	static bool on(std::size_t atIdx, F &f)
+	{
+		return onHot(atIdx, f, typename Table::template hot_candidates<E>{});
+	}
+
+private:
+	template<typename F>
+	static bool onHot(std::size_t atIdx, F &f, meta::list<>)
+	{
+		return onCandidates(atIdx, f, typename Table::template cold_candidates<E>{});
+	}
+
+	// hot states are checked first, one by one
+	template<typename F, typename I, typename... Is>
+	static bool onHot(std::size_t atIdx, F &f, meta::list<I, Is...>)
+	{
+		if (FSM_LIKELY(I::value == atIdx)) {
+			return f.template transit<I>();
+		}
+
+		return onHot(atIdx, f, meta::list<Is...>{});
+	}
+
+	template<typename F>
+	static bool onCandidates(std::size_t, F &, meta::list<>)
+	{
+		return false;
+	}
+
+	template<typename F, typename... Is>
+	static bool onCandidates(std::size_t atIdx, F &f, meta::list<Is...> l)
+	{
+		return onCandidatesImpl(atIdx, f, l,
+			meta::bool_<(sizeof...(Is) > Table::linear_dispatch_limit)>{});
+	}
+
+	// few candidates, compare them one by one
+	template<typename F, typename I, typename... Is>
+	static bool onCandidatesImpl(std::size_t atIdx, F &f, meta::list<I, Is...>, std::false_type)
+	{
+		if (I::value == atIdx) {
+			return onCold<I>(f, typename Table::has_hot{});
+		}
+
+		return onCandidates(atIdx, f, meta::list<Is...>{});
+	}
+
+	// many candidates, bisect sorted list of indices
+	template<typename F, typename L>
+	static bool onCandidatesImpl(std::size_t atIdx, F &f, L, std::true_type)
+	{
+		using halves = split<L>;
+
+		if (atIdx < meta::front<typename halves::second>::value) {
+			return onCandidates(atIdx, f, typename halves::first{});
+		}
+
+		return onCandidates(atIdx, f, typename halves::second{});
+	}
+
+	template<typename I, typename F>
+	static bool onCold(F &f, std::false_type)
+	{
+		return f.template transit<I>();
+	}
+
+	// transition not marked as hot in a table with hot transitions
+	template<typename I, typename F>
+	FSM_COLD static bool onCold(F &f, std::true_type)
+	{
+		return f.template transit<I>();
+	}
+};
 
 } // namespace detail
 
-// defines one transition between two states, this is type triple:
-// StartState, Event trigger, StopState
-template<typename S1, typename E, typename S2>
-struct transition
+namespace detail
+{
+
+template<typename S, typename = void>
+struct is_behavior_free : public std::false_type {};
+
+template<typename S>
+struct is_behavior_free<S, typename make_void<typename S::behavior_free>::type> :
+	public S::behavior_free
 {
-	using start_t = S1;
-	using stop_t = S2;
-	using event_t = E;
 };
 
-template<typename... Ts>
-struct transitions
+// transition T moved to start in S1 and stop in S2
+template<typename T, typename S1, typename S2>
+struct rebind_transition;
+
+template<typename A, typename E, typename B, typename G, typename F, typename S1, typename S2>
+struct rebind_transition<transition<A, E, B, G, F>, S1, S2>
 {
-	using list = meta::list<Ts...>;
+	using type = transition<S1, E, S2, G, F>;
+};
 
-	struct start_states_selector {
+// start and stop of internal transition are in the same block
+template<typename S, typename E, typename G, typename F, typename S1, typename S2>
+struct rebind_transition<internal<S, E, G, F>, S1, S2>
+{
+	using type = internal<S1, E, G, F>;
+};
+
+template<typename T, std::size_t W, typename S1, typename S2>
+struct rebind_transition<hot<T, W>, S1, S2>
+{
+	using type = hot<typename rebind_transition<T, S1, S2>::type, W>;
+};
+
+// indices don't hold in the new table
+template<typename T, std::size_t From, std::size_t To, typename S1, typename S2>
+struct rebind_transition<indexed<T, From, To>, S1, S2>
+{
+	using type = typename rebind_transition<T, S1, S2>::type;
+};
+
+// Moore partition refinement over states of Trs. Every state gets a block,
+// block of a state is index of the first state of that block, so it is
+// also index of the state representing the whole block. Only behavior-free
+// states without timeouts, guards and actions are merged, others stay in
+// their own blocks.
+template<typename Trs>
+struct minimizer
+{
+	using table_t = table<Trs>;
+	using indices = index_list<Trs::states_count::value>;
+
+	template<typename I>
+	using state_at = typename table_t::template index_to_state<I>;
+
+	template<typename S>
+	using state_timeouts_of = meta::filter<typename Trs::timeouts, timeout_in_selector<meta::list<S>>>;
+
+	struct has_functor_selector {
 		template<typename T>
-		using invoke = typename T::start_t;
+		using invoke = meta::bool_<!std::is_void<typename T::guard_t>::value ||
+			!std::is_void<typename T::action_t>::value>;
 	};
 
-	struct stop_states_selector {
-		template<typename T>
-		using invoke = typename T::stop_t;
+	template<typename S>
+	using state_functors_of = meta::filter<
+		meta::filter<typename Trs::list, starts_in_selector<meta::list<S>>>,
+		has_functor_selector>;
+
+	template<typename I>
+	using mergeable = meta::bool_<
+		is_behavior_free<state_at<I>>::value &&
+		meta::empty<state_timeouts_of<state_at<I>>>::value &&
+		meta::empty<state_functors_of<state_at<I>>>::value>;
+
+	struct mergeable_selector {
+		template<typename I>
+		using invoke = mergeable<I>;
 	};
 
-	using start_states = meta::transform<list, start_states_selector>;
-	using stop_states = meta::transform<list, stop_states_selector>;
-	using unique_states = meta::unique<meta::concat<start_states, stop_states>>;
+	// all mergeable states start in the same block
+	using first_mergeable = meta::find_if<indices, mergeable_selector>;
 
-	using states_tuple_t = meta::apply<meta::quote<std::tuple>, unique_states>;
-	using states_count = std::tuple_size<states_tuple_t>;
+	struct initial_block_func {
+		template<typename I>
+		using invoke = meta::if_<mergeable<I>, meta::front<meta::push_back<first_mergeable, I>>, I>;
+	};
 
-	struct state_events_func {
-		template<typename T>
-		using invoke = meta::list<typename T::start_t, typename T::event_t>;
+	using no_block = std::integral_constant<std::size_t, meta::npos>;
+
+	// block of destination of transition from state I on event E
+	template<typename Blocks, typename I, typename E, bool = table_t::template handle_event<state_at<I>, E>::value != 0>
+	struct dest_block
+	{
+		using type = meta::at<Blocks, typename table_t::template next_state_index<I, E>>;
 	};
 
-	// create list of lists. This is StartState, Event extract from transitions
-	using state_events = meta::transform<list, state_events_func>;
-};
+	template<typename Blocks, typename I, typename E>
+	struct dest_block<Blocks, I, E, false>
+	{
+		using type = no_block;
+	};
 
-template<typename, typename = detail::null_context> struct state_instances;
+	template<typename Blocks, typename I>
+	struct dest_block_func {
+		template<typename E>
+		using invoke = typename dest_block<Blocks, I, E>::type;
+	};
 
-template<typename... States>
-struct state_instances<std::tuple<States...>, detail::null_context>
-{
-	std::tuple<States...> states;
-};
+	// states with equal signatures stay in the same block
+	template<typename Blocks>
+	struct signature_func {
+		template<typename I>
+		using invoke = meta::if_<
+			mergeable<I>,
+			meta::concat<
+				meta::list<std::true_type, meta::at<Blocks, I>>,
+				meta::transform<typename Trs::events, dest_block_func<Blocks, I>>>,
+			meta::list<std::false_type, I>>;
+	};
 
-template<typename... States, typename Ctx>
-struct state_instances<std::tuple<States...>, Ctx>
-{
-	std::tuple<States...> states;
+	template<typename Signatures>
+	struct block_func {
+		template<typename Sig>
+		using invoke = meta::find_index<Signatures, Sig>;
+	};
 
-	state_instances(Ctx &ctx) :
-		states (std::make_tuple(States(ctx)...))
+	template<typename Blocks>
+	using refine = meta::transform<
+		meta::transform<indices, signature_func<Blocks>>,
+		block_func<meta::transform<indices, signature_func<Blocks>>>>;
+
+	template<typename Blocks, typename Next = refine<Blocks>>
+	struct fixpoint
 	{
-	}
-};
+		using type = typename fixpoint<Next>::type;
+	};
 
-template<std::size_t ID>
-struct state : public std::integral_constant<std::size_t, ID> {
+	template<typename Blocks>
+	struct fixpoint<Blocks, Blocks>
+	{
+		using type = Blocks;
+	};
+
+	using blocks = typename fixpoint<meta::transform<indices, initial_block_func>>::type;
+
+	template<typename S>
+	using representative = state_at<meta::at<blocks, typename table_t::template state_to_index<S>>>;
+
+	struct rebind_func {
+		template<typename T>
+		using invoke = typename rebind_transition<
+			T,
+			representative<typename T::start_t>,
+			representative<typename T::stop_t>>::type;
+	};
+
+	using type = meta::apply<
+		meta::quote<transitions>,
+		meta::concat<
+			meta::unique<meta::transform<typename Trs::list, rebind_func>>,
+			typename Trs::timeouts,
+			typename Trs::initial_entries>>;
 };
 
+} // namespace detail
+
+// transition table Trs with equivalent states merged. States declaring
+// `using behavior_free = std::true_type;` promise their hooks do nothing
+// and their event() always returns true, such states are equivalent if
+// the same events lead them to equivalent states. Merged states are
+// represented by the first one declared, initial state stays initial.
+template<typename Trs>
+using minimize = typename detail::minimizer<Trs>::type;
+
 template<typename Trs, typename Context = detail::null_context>
 struct fsm
 {
 private:
 	// helper templates all down to the public section
 	using Transitions = Trs;
+	using table_t = detail::table<Trs>;
 
-	// count all (S[tartState], E[vent]) pairs in provided list
-	// this one is needed to determine if specified state S is handling event E
-	template<typename S, typename E>
-	using handle_event = meta::count<
-		typename Transitions::state_events,
-		meta::list<S, E>>;
+	// calls back the machine for state found by dispatcher
+	template<typename E, typename Observer = detail::null_observer>
+	struct handler {
+		fsm &machine;
+		const E &event;
+		Observer &observer;
 
-	// meta-function for checking if provided T (struct transition) has the same S[tate] and E[vent]
-	// as provided in template arguments
-	template<typename S, typename E>
-	struct check_dest {
-		template<typename T>
-		using invoke = meta::and_<std::is_same<S, typename T::start_t>, std::is_same<E, typename T::event_t>>;
+		template<typename I>
+		bool transit() { return machine.onImpl<E, I>(event, observer); }
 	};
 
-	// selecting transition matching StartState-Event criteria
-	template<typename S, typename E>
-	using destination = meta::front<meta::find_if<typename Transitions::list, check_dest<S, E>>>;
+public:
+	// type used to store index of current state, it is the smallest
+	// unsigned type able to index all states of the machine
+	using index_t = detail::index_type<Transitions::states_count::value>;
 
-	// determining stop state from StartState, Event pair
-	template<typename S, typename E>
-	using destination_state = typename destination<S, E>::stop_t;
+private:
+	using data_t = detail::machine_data<typename Trs::states_tuple_t, Context, index_t,
+		detail::keeps_functor_context<Trs, Context>::value>;
 
-	template<typename I>
-	using index_to_state = typename std::tuple_element<I::value, typename Transitions::states_tuple_t>::type;
+	template<typename E>
+	struct nothrow_alternative_func {
+		template<typename A>
+		using invoke = meta::bool_<
+			noexcept(detail::guard<typename A::type::guard_t>::check(
+				std::declval<data_t &>().functorContext(), std::declval<const E &>(), 0)) &&
+			noexcept(detail::action<typename A::type::action_t>::run(
+				std::declval<data_t &>().functorContext(), std::declval<const E &>(), 0)) &&
+			noexcept(std::declval<data_t &>().template enter<A::stop_index::value>())>;
+	};
+
+	// guards, actions and enter() of every alternative
+	template<typename I, typename E, bool = Transitions::guarded::value>
+	struct nothrow_alternatives : public nothrow_alternative_func<E>::template invoke<
+		typename table_t::template candidate_transition<I, E>>
+	{
+	};
 
 	template<typename I, typename E>
-	using next_state = destination_state<index_to_state<I>, E>;
+	struct nothrow_alternatives<I, E, true> : public meta::bool_<meta::count<
+		meta::transform<typename table_t::template alternatives<I, E>, nothrow_alternative_func<E>>,
+		std::false_type>::value == 0>
+	{
+	};
 
-	template<typename T>
-	using state_to_index = meta::find_index<meta::as_list<typename Transitions::states_tuple_t>, T>;
+	template<typename E>
+	struct nothrow_transition_func {
+		template<typename I>
+		using invoke = meta::bool_<
+			noexcept(std::declval<data_t &>().template event<I::value>(std::declval<const E &>())) &&
+			noexcept(std::declval<data_t &>().template exit<I::value>()) &&
+			nothrow_alternatives<I, E>::value>;
+	};
 
-	template<typename I, typename E>
-	using next_state_index = state_to_index<next_state<I, E>>;
+public:
+	// context type, for flyweight machines this is the wrapped type
+	using context_t = typename data_t::context_t;
+
+private:
+	template<typename E>
+	struct nothrow_on_impl : public meta::bool_<meta::count<
+		meta::transform<typename table_t::template candidates<E>, nothrow_transition_func<E>>,
+		std::false_type>::value == 0>
+	{
+	};
+
+#if FSM_VARIANT
+	template<typename... Es>
+	struct nothrow_on_impl<std::variant<Es...>> : public meta::and_<nothrow_on_impl<Es>...>
+	{
+	};
+#endif
 
 public:
-	fsm() :
-		current (0)
+	// true if none of the hooks run when handling E can throw, on(E)
+	// is noexcept then
+	template<typename E>
+	using nothrow_on = meta::bool_<nothrow_on_impl<E>::value>;
+
+	// initial state is entered right away
+	fsm()
 	{
-		std::get<0>(instances.states).enter();
+		detail::reachability_check<Transitions::all_reachable::value>::check();
+		start();
 	}
 
-	fsm(Context &ctx) :
-		instances (ctx),
-		current (0)
+	fsm(typename data_t::ctor_arg_t ctx) :
+		data (ctx)
 	{
+		detail::reachability_check<Transitions::all_reachable::value>::check();
+		start();
 	}
 
-	// handle event E
+	// initial state is entered by start(), until then no event is
+	// handled and currentState() is 0
+	explicit fsm(lazy_start_t)
+	{
+		detail::reachability_check<Transitions::all_reachable::value>::check();
+	}
+
+	fsm(typename data_t::ctor_arg_t ctx, lazy_start_t) :
+		data (ctx)
+	{
+		detail::reachability_check<Transitions::all_reachable::value>::check();
+	}
+
+	// enter initial state, false if machine was already started
+	bool start() noexcept(noexcept(std::declval<data_t &>().template enter<0>()))
+	{
+		if (started()) {
+			return false;
+		}
+
+		data.template enter<0>();
+		data.current = 0;
+		return true;
+	}
+
+	bool started() const
+	{
+		return data.current != data_t::not_started;
+	}
+
+	// handle event E. If a hook throws the machine stays in the state it
+	// was in: exception from event() or exit() leaves it as it was, when
+	// enter() of the next state throws the start state is entered again.
+	// Defined out of line so FSM_EXTERN_DISPATCH can suppress it.
+	template<typename E>
+	bool on(const E &event) noexcept(nothrow_on<E>::value);
+
+	// true if current state has a transition triggered by E, costs one
+	// load and a bit test. on(E) may still be rejected by event() of the
+	// state, nothing is called here.
 	template<typename E>
-	bool on(const E &event)
+	bool canHandle() const
 	{
-		return onForAllImpl(event, current, meta::make_index_sequence<Transitions::states_count::value>{});
+		return detail::event_mask_test<table_t, E>::test(data.current);
 	}
 
+#if FSM_VARIANT
+	// handle event held by the variant. Current state and index of the
+	// alternative select the handler from a single flat table, so this is
+	// one indirect call instead of std::visit followed by on(E).
+	template<typename... Es>
+	bool on(const std::variant<Es...> &event) noexcept(nothrow_on<std::variant<Es...>>::value)
+	{
+		detail::null_observer observer;
+		return onObserved(event, observer);
+	}
+#endif
+
 	std::size_t currentState()
 	{
-		return currentStateForAll(current, meta::make_index_sequence<Transitions::states_count::value>{});
+		return table_t::state_id(data.current);
+	}
+
+	// position of current state in Transitions::states_tuple_t
+	index_t currentIndex() const
+	{
+		return data.current;
+	}
+
+	// position of state with given ID, number of states if there is none
+	static index_t indexOf(std::size_t id)
+	{
+		return table_t::template state_index<index_t>(id);
+	}
+
+	// make state with given ID current without calling any hooks, e.g. to
+	// restore machine saved by currentState(). False for unknown ID.
+	bool setStateById(std::size_t id)
+	{
+		const index_t i = indexOf(id);
+
+		if (i == data_t::not_started) {
+			return false;
+		}
+
+		data.current = i;
+		return true;
+	}
+
+	// context owned by flyweight machine
+	context_t &context()
+	{
+		return data.context;
+	}
+
+protected:
+	// handle event E as on() does, observer.template selected<T>() is
+	// called with transition T of the table picked for current state, by
+	// its guard if there are several, before event() of the state. It is
+	// not called when no transition was picked. Observer must not throw.
+	template<typename E, typename Observer>
+	bool onObserved(const E &event, Observer &observer) noexcept(nothrow_on<E>::value)
+	{
+		handler<E, Observer> h{*this, event, observer};
+		return detail::dispatcher<table_t, E>::on(data.current, h);
+	}
+
+#if FSM_VARIANT
+	template<typename... Es, typename Observer>
+	bool onObserved(const std::variant<Es...> &event, Observer &observer)
+		noexcept(nothrow_on<std::variant<Es...>>::value)
+	{
+		using table = variant_table<std::variant<Es...>, Observer>;
+
+		// valueless variant has index variant_npos, it wraps to column 0
+		return table::value[data.current * table::columns + (event.index() + 1)](*this, event, observer);
 	}
+#endif
 
 private:
-	template<std::size_t... Is>
-	std::size_t currentStateForAll(int index, meta::index_sequence<Is...>)
+	// state at index I is current one and has a transition triggered by E
+	template<typename E, typename I, typename Observer>
+	bool onImpl(const E &event, Observer &observer)
 	{
-		std::size_t currentId = 0;
+		return onAlternatives<E, I>(event, observer, typename Transitions::guarded{});
+	}
 
-		int dummy[Transitions::states_count::value] = {
-			(
-				currentStateImpl<std::integral_constant<std::size_t, Is>>(index, currentId),
-				0
-			)...
-		};
-		(void)dummy;
+	template<typename E, typename I, typename Observer>
+	bool onAlternatives(const E &event, Observer &observer, std::false_type)
+	{
+		static_assert(
+			table_t::template unique_transition<I, E>::value,
+			"only one transition from a state can be triggered by the same event unless "
+			"guards tell them apart, see fsm::determinize and fsm::nfa in fsm/nfa.hpp");
 
-		return currentId;
+		return take<E, I, typename table_t::template candidate_transition<I, E>>(event, observer);
 	}
 
-	template<typename I>
-	void currentStateImpl(int index, std::size_t &currentId)
+	template<typename E, typename I, typename Observer>
+	bool onAlternatives(const E &event, Observer &observer, std::true_type)
+	{
+		using alternatives = typename table_t::template alternatives<I, E>;
+
+		static_assert(
+			detail::guarded_alternatives<alternatives>::value,
+			"only one transition from a state can be triggered by the same event unless "
+			"guards tell them apart, see fsm::determinize and fsm::nfa in fsm/nfa.hpp");
+
+		return onAlternative<E, I>(event, observer, alternatives{});
+	}
+
+	template<typename E, typename I, typename Observer>
+	bool onAlternative(const E &, Observer &, meta::list<>)
+	{
+		return false;
+	}
+
+	// guards are checked before event() of the state, the first passing
+	// one selects the transition
+	template<typename E, typename I, typename Observer, typename A, typename... As>
+	bool onAlternative(const E &event, Observer &observer, meta::list<A, As...>)
 	{
-		if (I::value == index) {
-			currentId = std::tuple_element<I::value, typename Transitions::states_tuple_t>::type::value;
+		if (!detail::guard<typename A::type::guard_t>::check(data.functorContext(), event, 0)) {
+			return onAlternative<E, I>(event, observer, meta::list<As...>{});
 		}
+
+		return take<E, I, A>(event, observer);
 	}
 
-	template<typename E, std::size_t... Is>
-	bool onForAllImpl(const E &event, std::size_t atIdx, meta::index_sequence<Is...>)
+	// A is the selected transition with its type and stop_index
+	template<typename E, typename I, typename A, typename Observer>
+	bool take(const E &event, Observer &observer)
 	{
-		bool handled = false;
+		observer.template selected<typename A::type>();
+
+		return transitTo<E, I, A::stop_index::value, typename A::type::action_t>(
+			event, typename A::type::is_internal{});
+	}
 
-		int dummy[Transitions::states_count::value] = {
-			(
-				onImpl<E, std::integral_constant<std::size_t, Is>>(event, atIdx, handled),
-				0
-			)...
-		};
-		(void)dummy;
+	// internal transition, the state is not left
+	template<typename E, typename I, std::size_t Next, typename Action>
+	bool transitTo(const E &event, std::true_type)
+	{
+		if (!data.template event<I::value>(event)) {
+			return false;
+		}
 
-		return handled;
+		detail::action<Action>::run(data.functorContext(), event, 0);
+		return true;
 	}
 
-	template<typename E, typename I>
-	typename std::enable_if<handle_event<index_to_state<I>, E>::value == 1>::type
-	onImpl(const E &event, std::size_t atIdx, bool &handled, typename std::tuple_element<I::value, typename Transitions::states_tuple_t>::type* = nullptr)
+	template<typename E, typename I, std::size_t Next, typename Action>
+	bool transitTo(const E &event, std::false_type)
 	{
-		if (I::value == atIdx) {
-			if (std::get<I::value>(instances.states).event(event)) {
-				handled = true;
-				std::get<I::value>(instances.states).exit();
+		if (!data.template event<I::value>(event)) {
+			return false;
+		}
+
+		data.template exit<I::value>();
+		enterOrRollback<I::value, Next, Action>(event, meta::bool_<
+			noexcept(detail::action<Action>::run(data.functorContext(), event, 0)) &&
+			noexcept(data.template enter<Next>())>{});
+
+		data.current = static_cast<index_t>(Next);
+		return true;
+	}
+
+#if FSM_VARIANT
+	// handlers of variant V, row per state index including the one of
+	// machine which was not started, column per alternative preceded by
+	// one for valueless variant
+	template<typename V, typename Observer, typename = meta::make_index_sequence<
+		(Transitions::states_count::value + 1) * (std::variant_size_v<V> + 1)>>
+	struct variant_table;
+
+	template<typename... Es, typename Observer, std::size_t... Fs>
+	struct variant_table<std::variant<Es...>, Observer, meta::index_sequence<Fs...>>
+	{
+		using variant_t = std::variant<Es...>;
+		using handler_t = bool (*)(fsm &, const variant_t &, Observer &);
+
+		static constexpr std::size_t columns = sizeof...(Es) + 1;
+
+		static bool reject(fsm &, const variant_t &, Observer &) noexcept
+		{
+			return false;
+		}
 
-				std::get<
-					next_state_index<I, E>::value
-				>(instances.states).enter();
+		template<std::size_t I, std::size_t K>
+		static bool transit(fsm &machine, const variant_t &event, Observer &observer)
+		{
+			return machine.onImpl<std::variant_alternative_t<K, variant_t>, meta::size_t<I>>(
+				*std::get_if<K>(&event), observer);
+		}
 
-				current = next_state_index<I, E>::value;
+		template<std::size_t F, std::size_t I = F / columns, std::size_t K = F % columns>
+		static constexpr handler_t entry()
+		{
+			if constexpr (K == 0 || I == Transitions::states_count::value) {
+				return &reject;
+			} else if constexpr (meta::in<
+				typename table_t::template event_start_indices<std::variant_alternative_t<K - 1, variant_t>>,
+				meta::size_t<I>>::value) {
+				return &transit<I, K - 1>;
+			} else {
+				return &reject;
 			}
 		}
+
+		static constexpr handler_t value[] = {entry<Fs>()...};
+	};
+#endif
+
+	template<std::size_t From, std::size_t To, typename Action, typename E>
+	void enterOrRollback(const E &event, std::true_type) noexcept
+	{
+		detail::action<Action>::run(data.functorContext(), event, 0);
+		data.template enter<To>();
 	}
 
-	template<typename E, typename I>
-	typename std::enable_if<handle_event<index_to_state<I>, E>::value == 0>::type
-	onImpl(const E &event, std::size_t atIdx, bool &handled, typename std::tuple_element<I::value, typename Transitions::states_tuple_t>::type* = nullptr)
+	// state From was left already, enter it again if action of the
+	// transition throws or To can't be entered
+	template<std::size_t From, std::size_t To, typename Action, typename E>
+	void enterOrRollback(const E &event, std::false_type)
 	{
+#if FSM_EXCEPTIONS
+		try {
+			detail::action<Action>::run(data.functorContext(), event, 0);
+			data.template enter<To>();
+		} catch (...) {
+			data.template enter<From>();
+			throw;
+		}
+#else
+		detail::action<Action>::run(data.functorContext(), event, 0);
+		data.template enter<To>();
+#endif
 	}
 
 private:
-	state_instances<typename Trs::states_tuple_t, Context> instances;
-	int current;
+#if defined(FSM_CHECK_EMPTY_STATES)
+	// opt-in as empty states with a common empty base, e.g. the same ID,
+	// can't share one address and make the machine grow
+	static_assert(
+		!data_t::all_compressed::value || data_t::keeps_context::value || sizeof(data_t) == sizeof(index_t),
+		"machine with empty states should be as small as its index, "
+		"make sure empty states do not share a common empty base class");
+#endif
+
+	data_t data;
 };
 
+template<typename Trs, typename Context>
+template<typename E>
+bool fsm<Trs, Context>::on(const E &event) noexcept(nothrow_on<E>::value)
+{
+	detail::null_observer observer;
+	return onObserved(event, observer);
+}
+
 } // namespace fsm
 
+// FSM_PP_FOR_EACH(m, M, a, b, ...) expands to m(M, a); m(M, b); ...
+// without the last semicolon, for up to 16 arguments
+#define FSM_PP_EXPAND(x) x
+#define FSM_PP_EACH_1(m, M, a) m(M, a)
+#define FSM_PP_EACH_2(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_1(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_3(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_2(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_4(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_3(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_5(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_4(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_6(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_5(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_7(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_6(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_8(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_7(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_9(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_8(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_10(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_9(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_11(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_10(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_12(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_11(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_13(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_12(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_14(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_13(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_15(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_14(m, M, __VA_ARGS__))
+#define FSM_PP_EACH_16(m, M, a, ...) m(M, a); FSM_PP_EXPAND(FSM_PP_EACH_15(m, M, __VA_ARGS__))
+#define FSM_PP_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, ...) N
+#define FSM_PP_EACH_N(...) FSM_PP_EXPAND(FSM_PP_SELECT(__VA_ARGS__, \
+	FSM_PP_EACH_16, FSM_PP_EACH_15, FSM_PP_EACH_14, FSM_PP_EACH_13, \
+	FSM_PP_EACH_12, FSM_PP_EACH_11, FSM_PP_EACH_10, FSM_PP_EACH_9, \
+	FSM_PP_EACH_8, FSM_PP_EACH_7, FSM_PP_EACH_6, FSM_PP_EACH_5, \
+	FSM_PP_EACH_4, FSM_PP_EACH_3, FSM_PP_EACH_2, FSM_PP_EACH_1, ))
+#define FSM_PP_FOR_EACH(m, M, ...) FSM_PP_EXPAND(FSM_PP_EACH_N(__VA_ARGS__)(m, M, __VA_ARGS__))
+
+#define FSM_PP_EXTERN_ON(Machine, Event) extern template bool Machine::on<Event>(const Event &)
+#define FSM_PP_INSTANTIATE_ON(Machine, Event) template bool Machine::on<Event>(const Event &)
+
+// Dispatch of Machine, an alias of fsm::fsm type, for listed events (up to
+// 16 per use) instantiated in a single translation unit. Put
+//
+//	FSM_EXTERN_DISPATCH(my_machine, EventA, EventB);
+//
+// at global scope of the header declaring my_machine and
+//
+//	FSM_INSTANTIATE_DISPATCH(my_machine, EventA, EventB);
+//
+// into one source file. Other translation units then call on() of these
+// events without instantiating the dispatch, only the transition table
+// itself is still evaluated there. Calls are not inlined across units.
+#define FSM_EXTERN_DISPATCH(Machine, ...) FSM_PP_FOR_EACH(FSM_PP_EXTERN_ON, Machine, __VA_ARGS__)
+#define FSM_INSTANTIATE_DISPATCH(Machine, ...) FSM_PP_FOR_EACH(FSM_PP_INSTANTIATE_ON, Machine, __VA_ARGS__)
+
 #endif // FSM_HPP
@@ -0,0 +1,732 @@
+#ifndef FSM_ASYNC_HPP
+#define FSM_ASYNC_HPP
+
+#include <fsm.hpp>
+
+#if !defined(__cpp_impl_coroutine)
+#	error "fsm/async.hpp requires C++20 coroutines"
+#endif
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace fsm
+{
+
+template<typename T = void> class task;
+
+namespace detail
+{
+
+struct task_promise_base
+{
+	// who to resume when the task is done, if post is set continuation
+	// is handed over to an executor instead of being resumed in place
+	std::coroutine_handle<> continuation = std::noop_coroutine();
+	void (*post)(void *, std::coroutine_handle<>) = nullptr;
+	void *executor = nullptr;
+	std::exception_ptr exception;
+
+	struct final_awaiter
+	{
+		bool await_ready() noexcept { return false; }
+
+		template<typename P>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+		{
+			task_promise_base &p = h.promise();
+
+			if (p.post) {
+				p.post(p.executor, p.continuation);
+				return std::noop_coroutine();
+			}
+
+			return p.continuation;
+		}
+
+		void await_resume() noexcept {}
+	};
+
+	std::suspend_always initial_suspend() noexcept { return {}; }
+	final_awaiter final_suspend() noexcept { return {}; }
+	void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template<typename T>
+struct task_promise : public task_promise_base
+{
+	task<T> get_return_object();
+	void return_value(T v) { value.emplace(std::move(v)); }
+
+	T result()
+	{
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+
+		return std::move(*value);
+	}
+
+	std::optional<T> value;
+};
+
+template<>
+struct task_promise<void> : public task_promise_base
+{
+	task<void> get_return_object();
+	void return_void() {}
+
+	void result()
+	{
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+	}
+};
+
+} // namespace detail
+
+// coroutine returned by asynchronous state hooks, e.g. task<> enter() or
+// task<bool> event(const E &). It does not run until it is awaited.
+template<typename T>
+class task
+{
+public:
+	using promise_type = detail::task_promise<T>;
+	using handle_t = std::coroutine_handle<promise_type>;
+
+	explicit task(handle_t h) :
+		handle (h)
+	{
+	}
+
+	task(task &&other) noexcept :
+		handle (std::exchange(other.handle, nullptr))
+	{
+	}
+
+	task(const task &) = delete;
+	task &operator=(const task &) = delete;
+
+	~task()
+	{
+		if (handle) {
+			handle.destroy();
+		}
+	}
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+	{
+		handle.promise().continuation = continuation;
+		return handle;
+	}
+
+	T await_resume()
+	{
+		return handle.promise().result();
+	}
+
+	// resume awaiting coroutine through executor once the task is done
+	template<typename Executor>
+	task &&resumeOn(Executor &executor) &&
+	{
+		handle.promise().executor = &executor;
+		handle.promise().post = [](void *e, std::coroutine_handle<> h) {
+			static_cast<Executor *>(e)->post([h] { h.resume(); });
+		};
+
+		return std::move(*this);
+	}
+
+private:
+	handle_t handle;
+};
+
+namespace detail
+{
+
+template<typename T>
+task<T> task_promise<T>::get_return_object()
+{
+	return task<T>{std::coroutine_handle<task_promise<T>>::from_promise(*this)};
+}
+
+inline task<void> task_promise<void>::get_return_object()
+{
+	return task<void>{std::coroutine_handle<task_promise<void>>::from_promise(*this)};
+}
+
+// coroutine owning itself, started right away and destroyed when done
+struct detached
+{
+	struct promise_type
+	{
+		detached get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+template<typename T>
+struct is_task : public std::false_type {};
+
+template<typename T>
+struct is_task<task<T>> : public std::true_type {};
+
+// result of synchronous hook, ready right away
+template<typename T>
+struct ready
+{
+	bool await_ready() const noexcept { return true; }
+	void await_suspend(std::coroutine_handle<>) noexcept {}
+	T await_resume() { return std::move(value); }
+
+	T value;
+};
+
+template<>
+struct ready<void>
+{
+	bool await_ready() const noexcept { return true; }
+	void await_suspend(std::coroutine_handle<>) noexcept {}
+	void await_resume() noexcept {}
+};
+
+// runs synchronous hook f, exception thrown by it is stored to error and
+// the result is value initialized then
+template<typename F>
+ready<std::invoke_result_t<F &>> ready_result(F &&f, std::exception_ptr &error)
+{
+	using result_t = std::invoke_result_t<F &>;
+
+#if FSM_EXCEPTIONS
+	try {
+		if constexpr (std::is_void_v<result_t>) {
+			f();
+			return {};
+		} else {
+			return {f()};
+		}
+	} catch (...) {
+		error = std::current_exception();
+		return {};
+	}
+#else
+	(void) error;
+
+	if constexpr (std::is_void_v<result_t>) {
+		f();
+		return {};
+	} else {
+		return {f()};
+	}
+#endif
+}
+
+// awaitable A storing exception of its result to error instead of
+// throwing it
+template<typename A>
+struct catching
+{
+	using result_t = decltype(std::declval<A &>().await_resume());
+
+	bool await_ready() { return inner.await_ready(); }
+	auto await_suspend(std::coroutine_handle<> h) { return inner.await_suspend(h); }
+
+	result_t await_resume()
+	{
+#if FSM_EXCEPTIONS
+		try {
+			return inner.await_resume();
+		} catch (...) {
+			error = std::current_exception();
+			return result_t();
+		}
+#else
+		return inner.await_resume();
+#endif
+	}
+
+	A inner;
+	std::exception_ptr &error;
+};
+
+} // namespace detail
+
+// executor running posted work when asked to, one instance is usually
+// shared by many machines and driven by a single thread
+class manual_executor
+{
+public:
+	template<typename F>
+	void post(F &&f)
+	{
+		queue.emplace_back(std::forward<F>(f));
+	}
+
+	// run single piece of work, false if there was none
+	bool runOne()
+	{
+		if (queue.empty()) {
+			return false;
+		}
+
+		auto f = std::move(queue.front());
+		queue.pop_front();
+		f();
+		return true;
+	}
+
+	// run until there is no more work, including work posted meanwhile
+	std::size_t run()
+	{
+		std::size_t count = 0;
+
+		while (runOne()) {
+			++count;
+		}
+
+		return count;
+	}
+
+private:
+	std::deque<std::function<void()>> queue;
+};
+
+// events arriving during asynchronous transition are handled after it, in order
+struct queue_events {};
+
+// events arriving during asynchronous transition are rejected
+struct reject_events {};
+
+// State machine which hooks may be coroutines returning fsm::task. While
+// a hook is suspended the machine stays in a transitional sub-state
+// (inTransition() is true, current state is still the source one) and
+// the transition continues on Executor once the hook is done. Executor
+// is anything with post(F) accepting void() callables. Transitions with
+// synchronous hooks only are run in place just as in fsm::fsm, without
+// any coroutine. Exceptions of hooks leave the machine as fsm::fsm does
+// and end the transition, they are thrown by on() or start() unless the
+// transition was suspended before, the executor rethrows them then.
+//
+// Machine is not thread safe, all its events have to be posted from
+// the thread driving its executor. It can't be copied or moved as pending
+// transitions refer to it.
+template<typename Trs, typename Context = detail::null_context,
+	typename Executor = manual_executor, typename Policy = queue_events>
+class async_fsm
+{
+	using Transitions = Trs;
+	using table_t = detail::table<Trs>;
+
+public:
+	using index_t = detail::index_type<Transitions::states_count::value>;
+
+private:
+	using data_t = detail::machine_data<typename Trs::states_tuple_t, Context, index_t,
+		detail::keeps_functor_context<Trs, Context>::value>;
+
+public:
+	using context_t = typename data_t::context_t;
+
+	// any event handled by this machine
+	using event_t = meta::apply<meta::quote<std::variant>, typename Transitions::events>;
+
+	// initial state is entered right away
+	explicit async_fsm(Executor &exec) :
+		executor (exec)
+	{
+		detail::reachability_check<Transitions::all_reachable::value>::check();
+		start();
+	}
+
+	async_fsm(Executor &exec, typename data_t::ctor_arg_t ctx) :
+		executor (exec),
+		data (ctx)
+	{
+		detail::reachability_check<Transitions::all_reachable::value>::check();
+		start();
+	}
+
+	// initial state is entered by start()
+	async_fsm(Executor &exec, lazy_start_t) :
+		executor (exec)
+	{
+		detail::reachability_check<Transitions::all_reachable::value>::check();
+	}
+
+	async_fsm(Executor &exec, typename data_t::ctor_arg_t ctx, lazy_start_t) :
+		executor (exec),
+		data (ctx)
+	{
+		detail::reachability_check<Transitions::all_reachable::value>::check();
+	}
+
+	async_fsm(const async_fsm &) = delete;
+	async_fsm &operator=(const async_fsm &) = delete;
+
+	// handle event E, false if it was rejected right away (no transition
+	// from current state, guard returned false synchronously, or machine
+	// in transition with reject_events policy), true otherwise
+	template<typename E>
+	bool on(const E &event)
+	{
+		if (busy) {
+			return defer(event, Policy{}, meta::in<typename Transitions::events, E>{});
+		}
+
+		handler<E> h{*this, event};
+		return detail::dispatcher<table_t, E>::on(data.current, h);
+	}
+
+	// handle any event from event_t
+	bool on(const event_t &event)
+	{
+		return std::visit([this](const auto &e) { return on(e); }, event);
+	}
+
+	// enter initial state, false if machine was already started
+	bool start()
+	{
+		if (started() || busy) {
+			return false;
+		}
+
+		enterInitial(meta::bool_<synchronous<0>()>{});
+		return true;
+	}
+
+	bool started() const
+	{
+		return data.current != data_t::not_started;
+	}
+
+	bool inTransition() const
+	{
+		return busy;
+	}
+
+	std::size_t currentState()
+	{
+		return table_t::state_id(data.current);
+	}
+
+	index_t currentIndex() const
+	{
+		return data.current;
+	}
+
+	// position of state with given ID, number of states if there is none
+	static index_t indexOf(std::size_t id)
+	{
+		return table_t::template state_index<index_t>(id);
+	}
+
+	// make state with given ID current without calling any hooks, false
+	// for unknown ID or while in transition
+	bool setStateById(std::size_t id)
+	{
+		const index_t i = indexOf(id);
+
+		if (busy || i == data_t::not_started) {
+			return false;
+		}
+
+		data.current = i;
+		return true;
+	}
+
+	// context owned by flyweight machine
+	context_t &context()
+	{
+		return data.context;
+	}
+
+private:
+	template<typename E>
+	struct handler {
+		async_fsm &machine;
+		const E &event;
+
+		template<typename I>
+		bool transit()
+		{
+			using alternatives = typename table_t::template alternatives<I, E>;
+
+			static_assert(
+				detail::guarded_alternatives<alternatives>::value,
+				"only one transition from a state can be triggered by the same event unless "
+				"guards tell them apart");
+
+			return machine.select<I>(event, alternatives{});
+		}
+	};
+
+	template<typename I, typename E>
+	bool select(const E &, meta::list<>)
+	{
+		return false;
+	}
+
+	// guards are synchronous, they are checked before event() of the state
+	// and the first passing one selects the transition
+	template<typename I, typename E, typename A, typename... As>
+	bool select(const E &event, meta::list<A, As...>)
+	{
+		if (!detail::guard<typename A::type::guard_t>::check(data.functorContext(), event, 0)) {
+			return select<I>(event, meta::list<As...>{});
+		}
+
+		constexpr bool internal = A::type::is_internal::value;
+		using action_t = typename A::type::action_t;
+
+		if constexpr (synchronous<I::value, E>() &&
+			(internal || synchronous<I::value, A::stop_index::value>())) {
+			return transitNow<I::value, A::stop_index::value, internal, action_t>(event);
+		} else {
+			busy = true;
+			inPlace = true;
+			transit<I::value, A::stop_index::value, internal, action_t>(event);
+			inPlace = false;
+			rethrowFailure();
+
+			// synchronous hooks are already done at this point
+			return busy ? true : result;
+		}
+	}
+
+	template<typename R>
+	static constexpr bool synchronous_result()
+	{
+		return !detail::is_task<R>::value;
+	}
+
+	// event() of state at index I triggered by E is synchronous
+	template<std::size_t I, typename E>
+	static constexpr bool synchronous()
+	{
+		return synchronous_result<decltype(std::declval<data_t &>().template event<I>(std::declval<const E &>()))>();
+	}
+
+	// enter() and exit() of states at given indices are synchronous
+	template<std::size_t... Is>
+	static constexpr bool synchronous()
+	{
+		return (... && (
+			synchronous_result<decltype(std::declval<data_t &>().template enter<Is>())>() &&
+			synchronous_result<decltype(std::declval<data_t &>().template exit<Is>())>()));
+	}
+
+	// ends synchronous transition however it ends
+	struct settle
+	{
+		~settle()
+		{
+			machine.finish(accepted, nullptr);
+		}
+
+		async_fsm &machine;
+		bool accepted;
+	};
+
+	// every hook on the way is synchronous, no coroutine is needed. Hooks
+	// throw just as in fsm::fsm.
+	template<std::size_t I, std::size_t Next, bool Internal, typename Action, typename E>
+	bool transitNow(const E &event)
+	{
+		busy = true;
+		settle done{*this, false};
+
+		if (!data.template event<I>(event)) {
+			return false;
+		}
+
+		if constexpr (Internal) {
+			detail::action<Action>::run(data.functorContext(), event, 0);
+		} else {
+			data.template exit<I>();
+
+#if FSM_EXCEPTIONS
+			try {
+				detail::action<Action>::run(data.functorContext(), event, 0);
+				data.template enter<Next>();
+			} catch (...) {
+				data.template enter<I>();
+				throw;
+			}
+#else
+			detail::action<Action>::run(data.functorContext(), event, 0);
+			data.template enter<Next>();
+#endif
+
+			data.current = static_cast<index_t>(Next);
+		}
+
+		done.accepted = true;
+		return true;
+	}
+
+	template<typename E>
+	bool defer(const E &event, queue_events, std::true_type)
+	{
+		pending.emplace_back(event);
+		return true;
+	}
+
+	template<typename E>
+	bool defer(const E &, reject_events, std::true_type)
+	{
+		return false;
+	}
+
+	// nothing would handle it anyway
+	template<typename E, typename P>
+	bool defer(const E &, P, std::false_type)
+	{
+		return false;
+	}
+
+	// awaitable for hook result, asynchronous hooks resume on executor.
+	// Exception of the hook is stored to error, the result is then value
+	// initialized.
+	template<typename F>
+	auto awaitHook(F &&f, std::exception_ptr &error)
+	{
+		using result_t = decltype(f());
+
+		if constexpr (detail::is_task<result_t>::value) {
+			return detail::catching<result_t>{f().resumeOn(executor), error};
+		} else {
+			return detail::catching<detail::ready<result_t>>{
+				detail::ready_result(std::forward<F>(f), error), error};
+		}
+	}
+
+	void enterInitial(std::true_type)
+	{
+		busy = true;
+		settle done{*this, false};
+
+		data.template enter<0>();
+		data.current = 0;
+		done.accepted = true;
+	}
+
+	void enterInitial(std::false_type)
+	{
+		busy = true;
+		inPlace = true;
+		enterLater();
+		inPlace = false;
+		rethrowFailure();
+	}
+
+	detail::detached enterLater()
+	{
+		std::exception_ptr error;
+		co_await awaitHook([this] { return data.template enter<0>(); }, error);
+
+		if (!error) {
+			data.current = 0;
+		}
+
+		finish(!error, error);
+	}
+
+	// actions are synchronous, they run between exit() and enter(), or
+	// right after event() of the state for internal transitions. Hooks
+	// throwing leave the machine as fsm::fsm does, the source state is
+	// entered again when action or enter() of the next state throws.
+	template<std::size_t I, std::size_t Next, bool Internal, typename Action, typename E>
+	detail::detached transit(E event)
+	{
+		std::exception_ptr error;
+		const bool accepted = co_await awaitHook([&] { return data.template event<I>(event); }, error);
+		auto action = [&] { detail::action<Action>::run(data.functorContext(), event, 0); };
+
+		if (accepted && !error && Internal) {
+			co_await awaitHook(action, error);
+		} else if (accepted && !error) {
+			co_await awaitHook([this] { return data.template exit<I>(); }, error);
+
+			if (!error) {
+				co_await awaitHook(action, error);
+
+				if (!error) {
+					co_await awaitHook([this] { return data.template enter<Next>(); }, error);
+				}
+
+				if (error) {
+					// source state was left already, enter it again
+					std::exception_ptr rollback;
+					co_await awaitHook([this] { return data.template enter<I>(); }, rollback);
+					error = rollback ? rollback : error;
+				} else {
+					data.current = static_cast<index_t>(Next);
+				}
+			}
+		}
+
+		finish(accepted && !error, error);
+	}
+
+	void finish(bool accepted, std::exception_ptr error)
+	{
+		busy = false;
+		result = accepted;
+
+		// thrown by on() if nothing was suspended, by the executor otherwise
+		if (error && inPlace) {
+			failure = error;
+		} else if (error) {
+			executor.post([error] { std::rethrow_exception(error); });
+		}
+
+		if (!pending.empty()) {
+			executor.post([this] { drain(); });
+		}
+	}
+
+	void rethrowFailure()
+	{
+		if (failure) {
+			std::rethrow_exception(std::exchange(failure, nullptr));
+		}
+	}
+
+	// handle queued events until one of them starts asynchronous transition
+	void drain()
+	{
+		while (!busy && !pending.empty()) {
+			event_t event = std::move(pending.front());
+			pending.pop_front();
+			on(event);
+		}
+	}
+
+	Executor &executor;
+	data_t data;
+	std::deque<event_t> pending;
+	bool busy = false;
+	bool result = false;
+	// transition was started by on() or start() which is still running
+	bool inPlace = false;
+	std::exception_ptr failure;
+};
+
+} // namespace fsm
+
+#endif // FSM_ASYNC_HPP
@@ -0,0 +1,392 @@
+#ifndef FSM_DFA_HPP
+#define FSM_DFA_HPP
+
+#include <fsm.hpp>
+#include <cstdint>
+#include <string>
+
+#if defined(__SSSE3__)
+#	include <tmmintrin.h>
+#endif
+
+namespace fsm
+{
+
+namespace detail
+{
+
+constexpr bool byte_in(unsigned char b, const unsigned char *bytes, std::size_t n)
+{
+	return n != 0 && (bytes[0] == b || byte_in(b, bytes + 1, n - 1));
+}
+
+} // namespace detail
+
+// byte classes, events of tables used by fsm::dfa. Classes of one table
+// must not overlap, every byte belongs to at most one of them.
+
+// any of listed bytes
+template<char C, char... Cs>
+struct chars
+{
+	static constexpr unsigned char bytes[] = {static_cast<unsigned char>(C), static_cast<unsigned char>(Cs)...};
+
+	static constexpr bool contains(unsigned char b)
+	{
+		return detail::byte_in(b, bytes, sizeof...(Cs) + 1);
+	}
+};
+
+template<char C, char... Cs>
+constexpr unsigned char chars<C, Cs...>::bytes[];
+
+// bytes from Lo to Hi including both, compared as unsigned
+template<char Lo, char Hi>
+struct char_range
+{
+	static constexpr bool contains(unsigned char b)
+	{
+		return static_cast<unsigned char>(Lo) <= b && b <= static_cast<unsigned char>(Hi);
+	}
+};
+
+// all bytes not belonging to any other class of the table
+struct other_bytes
+{
+	static constexpr bool contains(unsigned char)
+	{
+		return false;
+	}
+};
+
+namespace detail
+{
+
+// position of the class containing byte b among Es, with other_bytes
+// as fallback and number of classes if there is none
+template<typename... Es>
+struct byte_class_of;
+
+template<>
+struct byte_class_of<>
+{
+	static constexpr std::size_t find(unsigned char, std::size_t, std::size_t other)
+	{
+		return other;
+	}
+
+	static constexpr std::size_t count(unsigned char)
+	{
+		return 0;
+	}
+};
+
+template<typename E, typename... Es>
+struct byte_class_of<E, Es...>
+{
+	static constexpr std::size_t find(unsigned char b, std::size_t pos, std::size_t other)
+	{
+		return E::contains(b) ? pos :
+			byte_class_of<Es...>::find(b, pos + 1, std::is_same<E, other_bytes>::value ? pos : other);
+	}
+
+	static constexpr std::size_t count(unsigned char b)
+	{
+		return (E::contains(b) ? 1 : 0) + byte_class_of<Es...>::count(b);
+	}
+};
+
+// class of every byte, classes are events of Trs in order of Trs::events
+template<typename Trs, typename Events = typename Trs::events,
+	typename Bs = meta::make_index_sequence<256>>
+struct byte_class_map;
+
+template<typename Trs, typename... Es, std::size_t... Bs>
+struct byte_class_map<Trs, meta::list<Es...>, meta::index_sequence<Bs...>>
+{
+	static_assert(sizeof...(Es) < 255, "too many byte classes");
+
+	static constexpr bool disjoint[] = {(byte_class_of<Es...>::count(static_cast<unsigned char>(Bs)) <= 1)...};
+
+	static_assert(meta::and_<meta::bool_<disjoint[Bs]>...>::value,
+		"byte classes of a table must not overlap");
+
+	static constexpr unsigned char value[] = {static_cast<unsigned char>(
+		byte_class_of<Es...>::find(static_cast<unsigned char>(Bs), 0, sizeof...(Es)))...};
+};
+
+template<typename Trs, typename... Es, std::size_t... Bs>
+constexpr bool byte_class_map<Trs, meta::list<Es...>, meta::index_sequence<Bs...>>::disjoint[];
+
+template<typename Trs, typename... Es, std::size_t... Bs>
+constexpr unsigned char byte_class_map<Trs, meta::list<Es...>, meta::index_sequence<Bs...>>::value[];
+
+// next state index of state I on class E, Reject if there is no transition
+template<typename Table, typename E, typename I, std::size_t Reject,
+	bool = meta::in<typename Table::template event_start_indices<E>, I>::value>
+struct dfa_next : public meta::size_t<Reject> {};
+
+template<typename Table, typename E, typename I, std::size_t Reject>
+struct dfa_next<Table, E, I, Reject, true> : public Table::template next_state_index<I, E>
+{
+	static_assert(Table::template unique_transition<I, E>::value,
+		"only one transition from a state can be triggered by the same byte class, "
+		"see fsm::determinize in fsm/nfa.hpp");
+};
+
+} // namespace detail
+
+// Deterministic automaton over bytes built from transition table Trs
+// which events are byte classes (fsm::chars, fsm::char_range and
+// fsm::other_bytes). Every byte is mapped to its class by a 256 entry
+// map and the class selects the next state from a dense table, hooks of
+// states and actions of transitions are not called. Runs of bytes
+// keeping the current state are skipped 16 at a time when SSSE3 is
+// enabled.
+template<typename Trs>
+class dfa
+{
+	using table_t = detail::table<Trs>;
+	using events = typename Trs::events;
+
+	static constexpr std::size_t states = Trs::states_count::value;
+
+	static_assert(!Trs::guarded::value, "byte classes can't have guarded transitions");
+
+	// last column is for bytes of no class
+	static constexpr std::size_t columns = events::size() + 1;
+
+public:
+	using index_t = detail::index_type<states>;
+
+	// index of state after byte without transition
+	static constexpr index_t reject = static_cast<index_t>(states);
+
+	// initial state is current one
+	dfa() = default;
+
+	// consume bytes until one of them has no transition from the current
+	// state, returns number of consumed bytes. The rejected byte is left
+	// unconsumed and the machine stays in the state before it.
+	std::size_t feed(const char *data, std::size_t n)
+	{
+		const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+		index_t s = current;
+		std::size_t i = 0;
+
+		while (i < n) {
+			const std::size_t end = n - i < run_block ? n : i + run_block;
+			index_t moved = 0;
+
+			// plain walk of a block, state changes are only collected
+			for (; i < end; ++i) {
+				const index_t next = step(s, bytes[i]);
+
+				if (next == reject) {
+					current = s;
+					return i;
+				}
+
+				moved |= static_cast<index_t>(next ^ s);
+				s = next;
+			}
+
+			// the whole block kept the state, skip the rest of the run
+			if (moved == 0) {
+				i = skipRun(s, bytes, i, n);
+			}
+		}
+
+		current = s;
+		return i;
+	}
+
+	std::size_t feed(const std::string &data)
+	{
+		return feed(data.data(), data.size());
+	}
+
+	// state reached from state index s by byte b, reject if there is none
+	static index_t step(index_t s, unsigned char b)
+	{
+		return transitions::value[s * columns + detail::byte_class_map<Trs>::value[b]];
+	}
+
+	std::size_t currentState() const
+	{
+		return table_t::state_id(current);
+	}
+
+	index_t currentIndex() const
+	{
+		return current;
+	}
+
+	// make state with given ID current, false for unknown ID
+	bool setStateById(std::size_t id)
+	{
+		const index_t i = table_t::template state_index<index_t>(id);
+
+		if (i == reject) {
+			return false;
+		}
+
+		current = i;
+		return true;
+	}
+
+	// back to initial state
+	void reset()
+	{
+		current = 0;
+	}
+
+private:
+	template<typename Fs = meta::make_index_sequence<states * columns>>
+	struct transitions_impl;
+
+	template<std::size_t... Fs>
+	struct transitions_impl<meta::index_sequence<Fs...>>
+	{
+		template<std::size_t F, std::size_t C = F % columns>
+		static constexpr index_t at()
+		{
+			return static_cast<index_t>(C == columns - 1 ? states :
+				detail::dfa_next<table_t, meta::at_c<events, (C < columns - 1 ? C : 0)>,
+					meta::size_t<F / columns>, states>::value);
+		}
+
+		static constexpr index_t value[] = {at<Fs>()...};
+	};
+
+	using transitions = transitions_impl<>;
+
+	// bytes walked one by one before a run is looked for, short runs are
+	// cheaper byte by byte and the check is paid once per block
+	static constexpr std::size_t run_block = 4;
+
+#if defined(__SSSE3__)
+	// nibble lookup tables of bytes keeping each state. Byte b keeps the
+	// state if hi[b >> 4] & lo[b & 15] is not zero, each high nibble gets
+	// a bit of its own set of low nibbles. Sets past the first eight use
+	// the second pair of tables.
+	struct run_tables
+	{
+		alignas(16) unsigned char lo[states][2][16];
+		alignas(16) unsigned char hi[states][2][16];
+		bool any[states];
+
+		run_tables()
+		{
+			for (std::size_t s = 0; s < states; ++s) {
+				std::uint16_t sets[16];
+				std::size_t distinct = 0;
+
+				any[s] = false;
+
+				for (std::size_t h = 0; h < 2; ++h) {
+					for (std::size_t k = 0; k < 16; ++k) {
+						lo[s][h][k] = hi[s][h][k] = 0;
+					}
+				}
+
+				for (std::size_t high = 0; high < 16; ++high) {
+					std::uint16_t set = 0;
+
+					for (std::size_t low = 0; low < 16; ++low) {
+						if (step(static_cast<index_t>(s), static_cast<unsigned char>(high << 4 | low)) == s) {
+							set |= std::uint16_t(1) << low;
+						}
+					}
+
+					if (set == 0) {
+						continue;
+					}
+
+					any[s] = true;
+
+					std::size_t id = 0;
+					while (id < distinct && sets[id] != set) {
+						++id;
+					}
+
+					if (id == distinct) {
+						sets[distinct++] = set;
+					}
+
+					const unsigned char bit = static_cast<unsigned char>(1 << (id % 8));
+					hi[s][id / 8][high] |= bit;
+
+					for (std::size_t low = 0; low < 16; ++low) {
+						if (set & (std::uint16_t(1) << low)) {
+							lo[s][id / 8][low] |= bit;
+						}
+					}
+				}
+			}
+		}
+	};
+
+	static const run_tables &runs()
+	{
+		static const run_tables tables;
+		return tables;
+	}
+
+	// position of the first byte from i on which leaves state s, or the
+	// last position checked by whole vectors
+	static std::size_t skipRun(index_t s, const unsigned char *bytes, std::size_t i, std::size_t n)
+	{
+		const run_tables &t = runs();
+
+		if (!t.any[s]) {
+			return i;
+		}
+
+		const __m128i nibble = _mm_set1_epi8(0x0f);
+		const __m128i lo0 = _mm_load_si128(reinterpret_cast<const __m128i *>(t.lo[s][0]));
+		const __m128i lo1 = _mm_load_si128(reinterpret_cast<const __m128i *>(t.lo[s][1]));
+		const __m128i hi0 = _mm_load_si128(reinterpret_cast<const __m128i *>(t.hi[s][0]));
+		const __m128i hi1 = _mm_load_si128(reinterpret_cast<const __m128i *>(t.hi[s][1]));
+
+		while (i + 16 <= n) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+			const __m128i low = _mm_and_si128(chunk, nibble);
+			const __m128i high = _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble);
+
+			const __m128i keeps = _mm_or_si128(
+				_mm_and_si128(_mm_shuffle_epi8(lo0, low), _mm_shuffle_epi8(hi0, high)),
+				_mm_and_si128(_mm_shuffle_epi8(lo1, low), _mm_shuffle_epi8(hi1, high)));
+
+			const unsigned leaves = static_cast<unsigned>(
+				_mm_movemask_epi8(_mm_cmpeq_epi8(keeps, _mm_setzero_si128())));
+
+			if (leaves != 0) {
+				return i + FSM_CTZ(leaves);
+			}
+
+			i += 16;
+		}
+
+		return i;
+	}
+#else
+	static std::size_t skipRun(index_t, const unsigned char *, std::size_t i, std::size_t)
+	{
+		return i;
+	}
+#endif
+
+	index_t current = 0;
+};
+
+template<typename Trs>
+constexpr typename dfa<Trs>::index_t dfa<Trs>::reject;
+
+template<typename Trs>
+template<std::size_t... Fs>
+constexpr typename dfa<Trs>::index_t dfa<Trs>::transitions_impl<meta::index_sequence<Fs...>>::value[];
+
+} // namespace fsm
+
+#endif // FSM_DFA_HPP
@@ -0,0 +1,411 @@
+#ifndef FSM_EXPORT_HPP
+#define FSM_EXPORT_HPP
+
+#include <fsm.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#if defined(__GXX_RTTI) || defined(_CPPRTTI) || defined(__cpp_rtti)
+#	include <typeinfo>
+#	if defined(__GNUG__)
+#		include <cstdlib>
+#		include <cxxabi.h>
+#	endif
+#endif
+
+namespace fsm
+{
+
+// counters of a single transition kept by fsm::profiled_fsm. Latency is
+// kept in power of two buckets of nanoseconds, percentiles are upper
+// bounds of the bucket they fall in.
+struct transition_counter
+{
+	static constexpr std::size_t buckets = 48;
+
+	// number of times the transition was taken
+	std::uint64_t hits = 0;
+	// number of times event() of its start state returned false
+	std::uint64_t rejected = 0;
+	std::uint64_t latency[buckets] = {};
+
+	void record(bool taken, std::chrono::nanoseconds elapsed)
+	{
+		if (!taken) {
+			++rejected;
+			return;
+		}
+
+		++hits;
+		++latency[bucketOf(elapsed.count() > 0 ? static_cast<std::uint64_t>(elapsed.count()) : 0)];
+	}
+
+	// latency in nanoseconds not exceeded by given fraction of hits
+	std::uint64_t percentile(double p) const
+	{
+		if (hits == 0) {
+			return 0;
+		}
+
+		const double rank = p * static_cast<double>(hits);
+		std::uint64_t seen = 0;
+
+		for (std::size_t i = 0; i < buckets; ++i) {
+			seen += latency[i];
+
+			if (seen > 0 && static_cast<double>(seen) >= rank) {
+				return (std::uint64_t(1) << (i + 1)) - 1;
+			}
+		}
+
+		return (std::uint64_t(1) << buckets) - 1;
+	}
+
+private:
+	// bucket i holds latencies in [2^i, 2^(i+1)), first one also zero
+	static std::size_t bucketOf(std::uint64_t ns)
+	{
+		std::size_t i = 0;
+
+		while (ns > 1 && i + 1 < buckets) {
+			ns >>= 1;
+			++i;
+		}
+
+		return i;
+	}
+};
+
+// counters of all transitions of Trs, in order of Trs::list
+template<typename Trs>
+struct transition_stats
+{
+	std::array<transition_counter, Trs::list::size()> transitions;
+
+	std::uint64_t totalHits() const
+	{
+		std::uint64_t total = 0;
+
+		for (const auto &t : transitions) {
+			total += t.hits;
+		}
+
+		return total;
+	}
+};
+
+namespace detail
+{
+
+// position in Trs::list of the transition picked by dispatch, npos if
+// the current state has none for the event or all its guards failed
+template<typename Trs>
+struct position_observer
+{
+	std::size_t position = meta::npos;
+
+	template<typename T>
+	void selected() noexcept
+	{
+		position = meta::find_index<typename Trs::list, T>::value;
+	}
+};
+
+template<typename E, typename = void>
+struct event_name
+{
+	static std::string get()
+	{
+#if defined(__GXX_RTTI) || defined(_CPPRTTI) || defined(__cpp_rtti)
+		const char *mangled = typeid(E).name();
+#	if defined(__GNUG__)
+		int status = 0;
+		char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+
+		if (status == 0 && demangled) {
+			std::string name(demangled);
+			std::free(demangled);
+			return name;
+		}
+#	endif
+		return mangled;
+#else
+		return "event";
+#endif
+	}
+};
+
+// events can name themselves with static member `name`
+template<typename E>
+struct event_name<E, typename make_void<decltype(E::name)>::type>
+{
+	static std::string get()
+	{
+		return E::name;
+	}
+};
+
+// guards and actions are named just like events, missing ones have no name
+template<>
+struct event_name<void>
+{
+	static std::string get()
+	{
+		return std::string();
+	}
+};
+
+inline void write_escaped(std::ostream &out, const std::string &s)
+{
+	for (char c : s) {
+		if (c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else if (c == '\n') {
+			out << "\\n";
+		} else {
+			out << c;
+		}
+	}
+}
+
+// everything exporters need to know about a single transition
+struct edge_info
+{
+	std::size_t from;
+	std::size_t to;
+	std::size_t weight;
+	std::string event;
+	std::string guard;
+	std::string action;
+	bool internal;
+};
+
+template<typename Trs>
+struct edge_list
+{
+	using table_t = table<Trs>;
+
+	template<typename T>
+	static edge_info edgeOf()
+	{
+		return edge_info{
+			table_t::template state_to_index<typename T::start_t>::value,
+			table_t::template state_to_index<typename T::stop_t>::value,
+			T::weight::value,
+			event_name<typename T::event_t>::get(),
+			event_name<typename T::guard_t>::get(),
+			event_name<typename T::action_t>::get(),
+			T::is_internal::value};
+	}
+
+	template<typename... Ts>
+	static std::array<edge_info, sizeof...(Ts)> edges(meta::list<Ts...>)
+	{
+		return {{edgeOf<Ts>()...}};
+	}
+
+	static std::array<edge_info, Trs::list::size()> get()
+	{
+		return edges(typename Trs::list{});
+	}
+};
+
+inline void write_latency_dot(std::ostream &out, const transition_counter &c)
+{
+	out << "\\nhits " << c.hits;
+
+	if (c.rejected) {
+		out << ", rejected " << c.rejected;
+	}
+
+	if (c.hits) {
+		out << "\\np50 " << c.percentile(0.5) << "ns, p99 " << c.percentile(0.99) << "ns";
+	}
+}
+
+} // namespace detail
+
+// write transition table Trs as Graphviz digraph, states are labelled by
+// their fsm::state<ID> values and transitions by names of their events
+// followed by guards in brackets and actions after a slash. Internal
+// transitions are dashed.
+// With stats edges show hit counts and latency percentiles, edges taking
+// larger share of hits are drawn thicker.
+template<typename Trs>
+void write_dot(std::ostream &out, const char *name = "fsm", const transition_stats<Trs> *stats = nullptr)
+{
+	const auto edges = detail::edge_list<Trs>::get();
+	const std::uint64_t total = stats ? stats->totalHits() : 0;
+
+	out << "digraph \"";
+	detail::write_escaped(out, name);
+	out << "\" {\n";
+
+	for (std::size_t i = 0; i < Trs::states_count::value; ++i) {
+		out << "\ts" << i << " [label=\"" << detail::table<Trs>::state_id(i) << "\""
+			<< (i == 0 ? ", shape=doublecircle" : "") << "];\n";
+	}
+
+	for (std::size_t i = 0; i < edges.size(); ++i) {
+		const detail::edge_info &e = edges[i];
+
+		out << "\ts" << e.from << " -> s" << e.to << " [label=\"";
+		detail::write_escaped(out, e.event);
+
+		if (!e.guard.empty()) {
+			out << " [";
+			detail::write_escaped(out, e.guard);
+			out << "]";
+		}
+
+		if (!e.action.empty()) {
+			out << " / ";
+			detail::write_escaped(out, e.action);
+		}
+
+		if (stats) {
+			detail::write_latency_dot(out, stats->transitions[i]);
+		}
+
+		out << "\"";
+
+		const bool bold = !(stats && total) && e.weight;
+
+		if (stats && total) {
+			out << ", penwidth=" << 1 + 4 * stats->transitions[i].hits / total;
+		}
+
+		if (bold && e.internal) {
+			out << ", style=\"bold,dashed\"";
+		} else if (bold) {
+			out << ", style=bold";
+		} else if (e.internal) {
+			out << ", style=dashed";
+		}
+
+		out << "];\n";
+	}
+
+	out << "}\n";
+}
+
+template<typename Trs>
+void write_dot(std::ostream &out, const transition_stats<Trs> &stats, const char *name = "fsm")
+{
+	write_dot<Trs>(out, name, &stats);
+}
+
+// write transition table Trs as JSON object with "states" and
+// "transitions" arrays, states are referred to by their indices
+template<typename Trs>
+void write_json(std::ostream &out, const transition_stats<Trs> *stats = nullptr)
+{
+	const auto edges = detail::edge_list<Trs>::get();
+
+	out << "{\"states\":[";
+
+	for (std::size_t i = 0; i < Trs::states_count::value; ++i) {
+		out << (i ? "," : "") << "{\"index\":" << i
+			<< ",\"id\":" << detail::table<Trs>::state_id(i)
+			<< ",\"initial\":" << (i == 0 ? "true" : "false") << "}";
+	}
+
+	out << "],\"transitions\":[";
+
+	for (std::size_t i = 0; i < edges.size(); ++i) {
+		const detail::edge_info &e = edges[i];
+
+		out << (i ? "," : "") << "{\"from\":" << e.from << ",\"to\":" << e.to << ",\"event\":\"";
+		detail::write_escaped(out, e.event);
+		out << "\"";
+
+		if (!e.guard.empty()) {
+			out << ",\"guard\":\"";
+			detail::write_escaped(out, e.guard);
+			out << "\"";
+		}
+
+		if (!e.action.empty()) {
+			out << ",\"action\":\"";
+			detail::write_escaped(out, e.action);
+			out << "\"";
+		}
+
+		if (e.internal) {
+			out << ",\"internal\":true";
+		}
+
+		out << ",\"weight\":" << e.weight;
+
+		if (stats) {
+			const transition_counter &c = stats->transitions[i];
+
+			out << ",\"hits\":" << c.hits << ",\"rejected\":" << c.rejected
+				<< ",\"latency_ns\":{\"p50\":" << c.percentile(0.5)
+				<< ",\"p90\":" << c.percentile(0.9)
+				<< ",\"p99\":" << c.percentile(0.99) << "}";
+		}
+
+		out << "}";
+	}
+
+	out << "]}\n";
+}
+
+template<typename Trs>
+void write_json(std::ostream &out, const transition_stats<Trs> &stats)
+{
+	write_json<Trs>(out, &stats);
+}
+
+// state machine counting hits, rejections and latency of every transition
+// of its table, meant for instrumented builds. Counts are exported with
+// write_dot() or write_json() and weights of fsm::hot come from them.
+template<typename Trs, typename Context = detail::null_context,
+	typename Clock = std::chrono::steady_clock>
+class profiled_fsm : public fsm<Trs, Context>
+{
+	using base = fsm<Trs, Context>;
+
+public:
+	using base::base;
+
+	// handle event E or std::variant of events, time spent in state hooks
+	// is recorded for the transition picked by dispatch, among guarded
+	// alternatives the one whose guard passed
+	template<typename E>
+	bool on(const E &event) noexcept(base::template nothrow_on<E>::value && noexcept(Clock::now()))
+	{
+		detail::position_observer<Trs> observer;
+		const typename Clock::time_point start = Clock::now();
+		const bool taken = this->onObserved(event, observer);
+
+		if (observer.position != meta::npos) {
+			counters.transitions[observer.position].record(taken,
+				std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start));
+		}
+
+		return taken;
+	}
+
+	const transition_stats<Trs> &stats() const
+	{
+		return counters;
+	}
+
+	void resetStats()
+	{
+		counters = transition_stats<Trs>{};
+	}
+
+private:
+	transition_stats<Trs> counters;
+};
+
+} // namespace fsm
+
+#endif // FSM_EXPORT_HPP
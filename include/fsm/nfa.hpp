@@ -0,0 +1,336 @@
+#ifndef FSM_NFA_HPP
+#define FSM_NFA_HPP
+
+#include <fsm.hpp>
+#include <cstdint>
+
+namespace fsm
+{
+
+// state of a table made by fsm::determinize, set of states of the
+// nondeterministic table it was built from. K is its position in order
+// of discovery, the initial set is 0. Sets have no behavior of their own,
+// their hooks are the noexcept ones of fsm::empty_state.
+template<std::size_t K, typename... States>
+struct subset_state : public empty_state<K>
+{
+	using behavior_free = std::true_type;
+
+	// states of the nondeterministic table, in their table order
+	using states = meta::list<States...>;
+
+	template<typename S>
+	using contains = meta::in<states, S>;
+};
+
+namespace detail
+{
+
+// bits of word w set for stop states of transitions [lo, hi) starting in
+// state s
+constexpr std::uint64_t successor_bits(std::size_t s,
+	const std::size_t *from, const std::size_t *to, std::size_t w, std::size_t lo, std::size_t hi)
+{
+	return hi - lo == 0 ? 0 :
+		hi - lo == 1 ?
+			(to[lo] / 64 == w && from[lo] == s ? std::uint64_t(1) << (to[lo] % 64) : 0) :
+		successor_bits(s, from, to, w, lo, lo + (hi - lo) / 2) |
+		successor_bits(s, from, to, w, lo + (hi - lo) / 2, hi);
+}
+
+// transitions of Trs triggered by E as state indices
+template<typename Trs, typename E>
+using nfa_edges = edge_indices<
+	typename Trs::unique_states,
+	typename table<Trs>::template event_transitions<E>>;
+
+// set of states reached from set Set by event E, nothing reached yields
+// a set of zero words
+template<typename Trs, typename Set, typename E, typename Words>
+struct nfa_step;
+
+template<typename Trs, typename Set, typename E, std::size_t... Ws>
+struct nfa_step<Trs, Set, E, meta::index_sequence<Ws...>>
+{
+	using edges = nfa_edges<Trs, E>;
+
+	using type = reached_words<reached_bits(Set::value, edges::from, edges::to, Ws, 0, edges::count)...>;
+};
+
+// transition of determinized table between sets at positions From and To
+template<std::size_t From, typename E, std::size_t To>
+struct subset_edge
+{
+	using event_t = E;
+};
+
+struct add_subset_func {
+	template<typename L, typename Set>
+	using invoke = meta::if_<meta::in<L, Set>, L, meta::push_back<L, Set>>;
+};
+
+// Subset construction, Subsets are sets found so far and K is the first
+// one not yet expanded. Every set is expanded by every event of Trs and
+// only sets reachable from the initial one are ever found.
+template<typename Trs, typename Words, typename Subsets, typename Edges, std::size_t K,
+	bool = K == Subsets::size()>
+struct subset_construction;
+
+template<typename Trs, std::size_t... Ws, typename Subsets, typename... Edges, std::size_t K>
+struct subset_construction<Trs, meta::index_sequence<Ws...>, Subsets, meta::list<Edges...>, K, false>
+{
+	using set = meta::at_c<Subsets, K>;
+	using none = reached_words<(Ws & 0)...>;
+
+	template<typename E>
+	using next = typename nfa_step<Trs, set, E, meta::index_sequence<Ws...>>::type;
+
+	struct reaches_func {
+		template<typename E>
+		using invoke = meta::not_<std::is_same<next<E>, none>>;
+	};
+
+	using events = meta::filter<typename Trs::events, reaches_func>;
+
+	struct next_func {
+		template<typename E>
+		using invoke = next<E>;
+	};
+
+	using subsets = meta::fold<meta::transform<events, next_func>, Subsets, add_subset_func>;
+
+	struct edge_func {
+		template<typename E>
+		using invoke = subset_edge<K, E, meta::find_index<subsets, next<E>>::value>;
+	};
+
+	using type = typename subset_construction<
+		Trs,
+		meta::index_sequence<Ws...>,
+		subsets,
+		meta::concat<meta::list<Edges...>, meta::transform<events, edge_func>>,
+		K + 1>::type;
+};
+
+template<typename Trs, typename Words, typename Subsets, typename Edges, std::size_t K>
+struct subset_construction<Trs, Words, Subsets, Edges, K, true>
+{
+	using subsets = Subsets;
+	using edges = Edges;
+	using type = subset_construction;
+};
+
+template<typename K, typename States>
+struct make_subset_state;
+
+template<typename K, typename... States>
+struct make_subset_state<K, meta::list<States...>>
+{
+	using type = subset_state<K::value, States...>;
+};
+
+template<typename Trs>
+struct determinizer
+{
+	static_assert(meta::empty<typename Trs::timeouts>::value,
+		"timeouts of nondeterministic tables are not supported");
+	static_assert(!Trs::guarded::value,
+		"transitions of nondeterministic tables can't have guards");
+
+	using nfa_states = typename Trs::unique_states;
+	using words = meta::make_index_sequence<(nfa_states::size() + 63) / 64>;
+
+	template<std::size_t... Ws>
+	static reached_words<(Ws == 0 ? 1 : 0)...> initial_set(meta::index_sequence<Ws...>);
+
+	using construction = typename subset_construction<
+		Trs,
+		words,
+		meta::list<decltype(initial_set(words{}))>,
+		meta::list<>,
+		0>::type;
+
+	using subsets = typename construction::subsets;
+
+	struct state_func {
+		template<typename K>
+		using invoke = typename make_subset_state<K,
+			typename reached_states<nfa_states, meta::at<subsets, K>,
+				meta::make_index_sequence<nfa_states::size()>>::type>::type;
+	};
+
+	using states = meta::transform<index_list<subsets::size()>, state_func>;
+
+	template<typename T>
+	struct transition_of;
+
+	template<std::size_t From, typename E, std::size_t To>
+	struct transition_of<subset_edge<From, E, To>>
+	{
+		using type = transition<meta::at_c<states, From>, E, meta::at_c<states, To>>;
+	};
+
+	struct transition_func {
+		template<typename T>
+		using invoke = typename transition_of<T>::type;
+	};
+
+	using type = meta::apply<
+		meta::quote<transitions>,
+		meta::push_back<
+			meta::transform<typename construction::edges, transition_func>,
+			initial<meta::front<states>>>>;
+};
+
+} // namespace detail
+
+// deterministic table equivalent to table Trs in which a state may have
+// several transitions triggered by the same event. States of the result
+// are fsm::subset_state of states of Trs active at once, only sets
+// reachable from the initial state are built. Hooks and event() of
+// states of Trs are dropped, so are actions and weights of transitions.
+template<typename Trs>
+using determinize = typename detail::determinizer<Trs>::type;
+
+// Bit-parallel simulation of nondeterministic table Trs, for tables
+// which determinized form would be too large. Active states are bits of
+// 64 bit words and an event ORs precomputed successor sets of every
+// active state. Like fsm::determinize hooks, event() and actions are not
+// called.
+template<typename Trs>
+class nfa
+{
+	using nfa_states = typename Trs::unique_states;
+
+	static constexpr std::size_t states = Trs::states_count::value;
+	static constexpr std::size_t words = (states + 63) / 64;
+
+	static_assert(!Trs::guarded::value,
+		"transitions of nondeterministic tables can't have guards");
+
+public:
+	// initial state is the only active one
+	nfa()
+	{
+		reset();
+	}
+
+	// make states reached from active ones by E active, false when E does
+	// not lead anywhere from any of them and active states stay the same
+	template<typename E>
+	bool on(const E &)
+	{
+		return onImpl(meta::in<typename Trs::events, E>{}, successors<E>{});
+	}
+
+	// S is active, S is a state of Trs
+	template<typename S>
+	bool isActive() const
+	{
+		return isActiveIndex(meta::find_index<nfa_states, S>::value);
+	}
+
+	bool isActiveIndex(std::size_t i) const
+	{
+		return i < states && (active[i / 64] >> (i % 64)) & 1;
+	}
+
+	// back to initial state only
+	void reset()
+	{
+		for (std::size_t w = 0; w < words; ++w) {
+			active[w] = 0;
+		}
+
+		active[0] = 1;
+	}
+
+private:
+	// successor words of every state on event E, row per state
+	template<typename E, typename Fs = meta::make_index_sequence<states * words>>
+	struct successors;
+
+	template<typename E, std::size_t... Fs>
+	struct successors<E, meta::index_sequence<Fs...>>
+	{
+		using edges = detail::nfa_edges<Trs, E>;
+
+		static constexpr std::uint64_t value[] = {
+			detail::successor_bits(Fs / words, edges::from, edges::to, Fs % words, 0, edges::count)...};
+	};
+
+	template<typename Successors>
+	bool onImpl(std::true_type, Successors)
+	{
+		std::uint64_t next[words] = {};
+
+		for (std::size_t w = 0; w < words; ++w) {
+			for (std::uint64_t bits = active[w]; bits != 0; bits &= bits - 1) {
+				const std::uint64_t *row = Successors::value +
+					(w * 64 + FSM_CTZ(bits)) * words;
+
+				for (std::size_t v = 0; v < words; ++v) {
+					next[v] |= row[v];
+				}
+			}
+		}
+
+		std::uint64_t any = 0;
+		for (std::size_t w = 0; w < words; ++w) {
+			any |= next[w];
+		}
+
+		if (any == 0) {
+			return false;
+		}
+
+		for (std::size_t w = 0; w < words; ++w) {
+			active[w] = next[w];
+		}
+
+		return true;
+	}
+
+	template<typename Successors>
+	bool onImpl(std::false_type, Successors)
+	{
+		return false;
+	}
+
+	std::uint64_t active[words];
+};
+
+template<typename Trs>
+template<typename E, std::size_t... Fs>
+constexpr std::uint64_t nfa<Trs>::successors<E, meta::index_sequence<Fs...>>::value[];
+
+namespace detail
+{
+
+template<typename States, typename S>
+struct subset_flags;
+
+template<typename... States, typename S>
+struct subset_flags<meta::list<States...>, S>
+{
+	static constexpr bool value[] = {States::template contains<S>::value...};
+};
+
+template<typename... States, typename S>
+constexpr bool subset_flags<meta::list<States...>, S>::value[];
+
+} // namespace detail
+
+// subset_state with given ID of fsm::determinize<Trs> contains state S
+// of Trs, false for unknown IDs
+template<typename Trs, typename S>
+bool subset_contains(std::size_t id)
+{
+	using states = typename detail::determinizer<Trs>::states;
+
+	return id < states::size() && detail::subset_flags<states, S>::value[id];
+}
+
+} // namespace fsm
+
+#endif // FSM_NFA_HPP
@@ -0,0 +1,200 @@
+#ifndef FSM_REACTOR_HPP
+#define FSM_REACTOR_HPP
+
+#include <fsm.hpp>
+
+#if !defined(__linux__)
+#	error "fsm/reactor.hpp requires Linux epoll"
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace fsm
+{
+
+// file descriptor registered in fsm::reactor, notifications are passed to
+// dispatch() which translates them to machine events. Handler memory is
+// owned by user, it has to stay in place while registered.
+struct fd_handler
+{
+	fd_handler(int fd, std::uint32_t interest) :
+		fd (fd),
+		interest (interest)
+	{
+	}
+
+	fd_handler(const fd_handler &) = delete;
+	fd_handler &operator=(const fd_handler &) = delete;
+
+	// called for every readiness notification, events is epoll mask
+	void (*dispatch)(fd_handler &, std::uint32_t events) = nullptr;
+
+	int fd;
+	std::uint32_t interest;
+};
+
+namespace detail
+{
+
+// events can carry the descriptor they are reported for
+template<typename E>
+typename std::enable_if<std::is_constructible<E, int>::value, E>::type
+make_fd_event(int fd)
+{
+	return E(fd);
+}
+
+template<typename E>
+typename std::enable_if<!std::is_constructible<E, int>::value, E>::type
+make_fd_event(int)
+{
+	return E{};
+}
+
+template<typename M, typename E>
+typename std::enable_if<std::is_void<E>::value>::type
+send_fd_event(M &, int)
+{
+}
+
+template<typename M, typename E>
+typename std::enable_if<!std::is_void<E>::value>::type
+send_fd_event(M &machine, int fd)
+{
+	machine.on(make_fd_event<E>(fd));
+}
+
+} // namespace detail
+
+// maps readiness of single descriptor onto events of Machine: Read when
+// data can be read, Write when data can be written and Hup when peer
+// hung up or descriptor failed. Use void for readiness of no interest.
+template<typename Machine, typename Read, typename Write = void, typename Hup = void>
+struct fd_watch : public fd_handler
+{
+	static constexpr std::uint32_t default_interest =
+		(std::is_void<Read>::value ? 0u : std::uint32_t(EPOLLIN)) |
+		(std::is_void<Write>::value ? 0u : std::uint32_t(EPOLLOUT)) |
+		(std::is_void<Hup>::value ? 0u : std::uint32_t(EPOLLRDHUP));
+
+	fd_watch(Machine &m, int fd) :
+		fd_handler (fd, default_interest),
+		machine (m)
+	{
+		dispatch = &dispatchImpl;
+	}
+
+private:
+	// pending input is handled before hang up so it is not lost
+	static void dispatchImpl(fd_handler &h, std::uint32_t events)
+	{
+		fd_watch &w = static_cast<fd_watch &>(h);
+
+		if (events & (EPOLLIN | EPOLLPRI)) {
+			detail::send_fd_event<Machine, Read>(w.machine, w.fd);
+		}
+
+		if (events & EPOLLOUT) {
+			detail::send_fd_event<Machine, Write>(w.machine, w.fd);
+		}
+
+		if (events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) {
+			detail::send_fd_event<Machine, Hup>(w.machine, w.fd);
+		}
+	}
+
+	Machine &machine;
+};
+
+template<typename Machine, typename Read, typename Write, typename Hup>
+constexpr std::uint32_t fd_watch<Machine, Read, Write, Hup>::default_interest;
+
+// epoll based reactor feeding descriptor readiness into state machines.
+// Single poll() waits once and dispatches up to batch_size notifications
+// so cost of the system call is shared by all ready descriptors.
+// System call failures are reported by return value with errno set.
+// Handler removed while poll() runs has to stay alive until it returns.
+class reactor
+{
+public:
+	static constexpr int batch_size = 64;
+
+	reactor() :
+		epfd (::epoll_create1(EPOLL_CLOEXEC))
+	{
+	}
+
+	reactor(const reactor &) = delete;
+	reactor &operator=(const reactor &) = delete;
+
+	~reactor()
+	{
+		if (epfd >= 0) {
+			::close(epfd);
+		}
+	}
+
+	bool valid() const
+	{
+		return epfd >= 0;
+	}
+
+	// start watching descriptor, with edge set notification is reported
+	// only when readiness changes
+	bool add(fd_handler &h, bool edge = false)
+	{
+		return control(EPOLL_CTL_ADD, h, edge);
+	}
+
+	// change readiness of interest, e.g. enable EPOLLOUT only when
+	// there is something to write
+	bool modify(fd_handler &h, std::uint32_t interest, bool edge = false)
+	{
+		h.interest = interest;
+		return control(EPOLL_CTL_MOD, h, edge);
+	}
+
+	bool remove(fd_handler &h)
+	{
+		return ::epoll_ctl(epfd, EPOLL_CTL_DEL, h.fd, nullptr) == 0;
+	}
+
+	// wait up to timeout milliseconds (-1 forever, 0 don't wait) and
+	// dispatch all reported notifications. Returns number of dispatched
+	// notifications, 0 if interrupted by a signal, -1 on error.
+	int poll(int timeout = -1)
+	{
+		const int n = ::epoll_wait(epfd, ready, batch_size, timeout);
+
+		if (n < 0) {
+			return errno == EINTR ? 0 : -1;
+		}
+
+		for (int i = 0; i < n; ++i) {
+			fd_handler &h = *static_cast<fd_handler *>(ready[i].data.ptr);
+			h.dispatch(h, ready[i].events);
+		}
+
+		return n;
+	}
+
+private:
+	bool control(int op, fd_handler &h, bool edge)
+	{
+		epoll_event ev{};
+		ev.events = h.interest | (edge ? std::uint32_t(EPOLLET) : 0u);
+		ev.data.ptr = &h;
+
+		return ::epoll_ctl(epfd, op, h.fd, &ev) == 0;
+	}
+
+	int epfd;
+	epoll_event ready[batch_size];
+};
+
+} // namespace fsm
+
+#endif // FSM_REACTOR_HPP
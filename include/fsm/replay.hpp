@@ -0,0 +1,251 @@
+#ifndef FSM_REPLAY_HPP
+#define FSM_REPLAY_HPP
+
+#include <fsm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__SSSE3__)
+#	include <tmmintrin.h>
+#endif
+
+namespace fsm
+{
+
+namespace detail
+{
+
+// stands for events of a log which no state handles
+struct no_event {};
+
+// index of state reached from state I by event E, I itself when it has
+// no transition triggered by E
+template<typename Table, typename E, typename I,
+	bool = meta::in<typename Table::template event_start_indices<E>, I>::value>
+struct replay_next : public I {};
+
+template<typename Table, typename E, typename I>
+struct replay_next<Table, E, I, true> : public Table::template next_state_index<I, E>
+{
+	static_assert(Table::template unique_transition<I, E>::value,
+		"only one transition from a state can be triggered by the same event, "
+		"see fsm::determinize in fsm/nfa.hpp");
+};
+
+} // namespace detail
+
+// Bulk replay of event logs over transition table Trs, computing state
+// indices only. Hooks and actions are not called and event() of every
+// state is taken to accept every event it has a transition for, so the
+// result matches fsm::fsm for behavior-free states (see fsm::minimize).
+//
+// Every event is a function state -> state and a log is their composition.
+// Composition is associative, so the log is split to chunks which are
+// composed on their own threads first. Start states of chunks then follow
+// from a short sequential scan, and trace() fills intermediate states of
+// all chunks in parallel again. With at most 16 states a composition step
+// is a single pshufb when SSSE3 is enabled, for larger tables each step
+// costs a pass over all states and fewer threads pay off less.
+template<typename Trs>
+class replay
+{
+	using table_t = detail::table<Trs>;
+	using events = meta::push_back<typename Trs::events, detail::no_event>;
+
+	static constexpr std::size_t states = Trs::states_count::value;
+
+	static_assert(!Trs::guarded::value, "guarded transitions can't be replayed without the machine");
+
+public:
+	using index_t = detail::index_type<states>;
+
+	// events are logged as their positions in Trs::events
+	using code_t = detail::index_type<events::size()>;
+
+	// rows of composed functions, padded to a full vector for small tables
+	static constexpr std::size_t width = states <= 16 ? 16 : states;
+
+	// code of event E, events without any transition get the last code
+	// which leaves every state as it is
+	template<typename E>
+	static constexpr code_t code()
+	{
+		return static_cast<code_t>(meta::find_index<events, E>::value == meta::npos ?
+			events::size() - 1 : meta::find_index<events, E>::value);
+	}
+
+	// index of state after all n events of log starting from state from,
+	// with threads = 0 all hardware threads are used
+	static index_t finalState(const code_t *log, std::size_t n, index_t from = 0, unsigned threads = 0)
+	{
+		return run(log, n, nullptr, from, threads);
+	}
+
+	// as finalState(), states[i] is set to the index after log[i]
+	static index_t trace(const code_t *log, std::size_t n, index_t *states, index_t from = 0, unsigned threads = 0)
+	{
+		return run(log, n, states, from, threads);
+	}
+
+	// state reached from state index s by event with code c
+	static index_t next(index_t s, code_t c)
+	{
+		return rows::value[c * width + s];
+	}
+
+private:
+	template<typename Fs = meta::make_index_sequence<events::size() * width>>
+	struct rows_impl;
+
+	template<std::size_t... Fs>
+	struct rows_impl<meta::index_sequence<Fs...>>
+	{
+		// padding lanes map to themselves so vectors stay within a row
+		template<std::size_t F, std::size_t S = F % width>
+		static constexpr index_t at()
+		{
+			return static_cast<index_t>(S < states ?
+				detail::replay_next<table_t, meta::at_c<events, F / width>,
+					meta::size_t<(S < states ? S : 0)>>::value :
+				S);
+		}
+
+		alignas(16) static constexpr index_t value[] = {at<Fs>()...};
+	};
+
+	using rows = rows_impl<>;
+
+	// composed function of a chunk, f[s] is state after the chunk from s
+	struct chunk_map
+	{
+		alignas(16) index_t f[width];
+	};
+
+	// too short chunks are not worth a thread
+	static constexpr std::size_t min_chunk = 1 << 14;
+
+	static index_t run(const code_t *log, std::size_t n, index_t *out, index_t from, unsigned threads)
+	{
+		if (threads == 0) {
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		const std::size_t chunks = std::min<std::size_t>(threads, std::max<std::size_t>(1, n / min_chunk));
+
+		if (chunks == 1) {
+			return walk(log, n, out, from);
+		}
+
+		const std::size_t size = (n + chunks - 1) / chunks;
+		std::vector<chunk_map> maps(chunks);
+
+		// last chunk is only walked, its map is never needed
+		parallel(chunks - 1, [&](std::size_t c) {
+			compose(log + c * size, size, maps[c]);
+		});
+
+		std::vector<index_t> starts(chunks);
+		starts[0] = from;
+
+		for (std::size_t c = 1; c < chunks; ++c) {
+			starts[c] = maps[c - 1].f[starts[c - 1]];
+		}
+
+		const std::size_t last = (chunks - 1) * size;
+
+		if (!out) {
+			return walk(log + last, n - last, nullptr, starts[chunks - 1]);
+		}
+
+		index_t result = from;
+
+		parallel(chunks, [&](std::size_t c) {
+			const std::size_t begin = c * size;
+			const index_t end = walk(log + begin, std::min(n, begin + size) - begin, out + begin, starts[c]);
+
+			if (c == chunks - 1) {
+				result = end;
+			}
+		});
+
+		return result;
+	}
+
+	template<typename F>
+	static void parallel(std::size_t count, F f)
+	{
+		std::vector<std::thread> workers;
+		workers.reserve(count - 1);
+
+		for (std::size_t c = 1; c < count; ++c) {
+			workers.emplace_back(f, c);
+		}
+
+		f(0);
+
+		for (auto &w : workers) {
+			w.join();
+		}
+	}
+
+	static index_t walk(const code_t *log, std::size_t n, index_t *out, index_t s)
+	{
+		for (std::size_t i = 0; i < n; ++i) {
+			s = next(s, log[i]);
+
+			if (out) {
+				out[i] = s;
+			}
+		}
+
+		return s;
+	}
+
+	static void compose(const code_t *log, std::size_t n, chunk_map &map)
+	{
+		compose(log, n, map, meta::bool_<width == 16 && sizeof(index_t) == 1>{});
+	}
+
+	// map = row(event) composed with map, for every state at once
+	static void compose(const code_t *log, std::size_t n, chunk_map &map, std::false_type)
+	{
+		for (std::size_t s = 0; s < width; ++s) {
+			map.f[s] = static_cast<index_t>(s);
+		}
+
+		for (std::size_t i = 0; i < n; ++i) {
+			const index_t *row = rows::value + log[i] * width;
+
+			for (std::size_t s = 0; s < states; ++s) {
+				map.f[s] = row[map.f[s]];
+			}
+		}
+	}
+
+	static void compose(const code_t *log, std::size_t n, chunk_map &map, std::true_type)
+	{
+#if defined(__SSSE3__)
+		__m128i f = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+		for (std::size_t i = 0; i < n; ++i) {
+			const __m128i row = _mm_load_si128(reinterpret_cast<const __m128i *>(rows::value + log[i] * width));
+			f = _mm_shuffle_epi8(row, f);
+		}
+
+		_mm_store_si128(reinterpret_cast<__m128i *>(map.f), f);
+#else
+		compose(log, n, map, std::false_type{});
+#endif
+	}
+};
+
+template<typename Trs>
+template<std::size_t... Fs>
+alignas(16) constexpr typename replay<Trs>::index_t
+	replay<Trs>::rows_impl<meta::index_sequence<Fs...>>::value[];
+
+} // namespace fsm
+
+#endif // FSM_REPLAY_HPP
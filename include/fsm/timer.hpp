@@ -0,0 +1,425 @@
+#ifndef FSM_TIMER_HPP
+#define FSM_TIMER_HPP
+
+#include <fsm.hpp>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+namespace fsm
+{
+
+// intrusive timer, memory is owned by whoever arms it so the wheel
+// itself never allocates. Node can't be moved while armed.
+struct timer_node
+{
+	timer_node() = default;
+	timer_node(const timer_node &) = delete;
+	timer_node &operator=(const timer_node &) = delete;
+
+	bool armed() const
+	{
+		return next != nullptr;
+	}
+
+	// called by the wheel once the timer expires
+	void (*fire)(timer_node &) = nullptr;
+
+private:
+	friend class timer_wheel;
+
+	timer_node *prev = nullptr;
+	timer_node *next = nullptr;
+	std::uint64_t expires = 0;
+};
+
+// hierarchical timer wheel, four levels of 256 slots. Arming and
+// cancelling is O(1), timers further than 2^32 ticks are clamped to
+// that distance. Time is advanced explicitly by the owner, one wheel is
+// meant to be shared by all machines of a thread.
+class timer_wheel
+{
+public:
+	static constexpr unsigned level_bits = 8;
+	static constexpr unsigned levels = 4;
+	static constexpr std::size_t slots = std::size_t(1) << level_bits;
+	static constexpr std::uint64_t slot_mask = slots - 1;
+	static constexpr std::uint64_t max_delay = (std::uint64_t(1) << (level_bits * levels)) - 1;
+
+	explicit timer_wheel(std::chrono::nanoseconds resolution = std::chrono::milliseconds(1)) :
+		tickLength (resolution)
+	{
+		for (auto &level : wheel) {
+			for (auto &slot : level) {
+				slot.prev = slot.next = &slot;
+			}
+		}
+	}
+
+	timer_wheel(const timer_wheel &) = delete;
+	timer_wheel &operator=(const timer_wheel &) = delete;
+
+	std::chrono::nanoseconds resolution() const
+	{
+		return tickLength;
+	}
+
+	// ticks since the wheel was created
+	std::uint64_t now() const
+	{
+		return ticks;
+	}
+
+	// number of armed timers
+	std::size_t size() const
+	{
+		return count;
+	}
+
+	// arm node to fire after given number of ticks, at least one,
+	// node which is already armed is re-armed
+	void arm(timer_node &node, std::uint64_t after)
+	{
+		cancel(node);
+
+		if (after == 0) {
+			after = 1;
+		} else if (after > max_delay) {
+			after = max_delay;
+		}
+
+		node.expires = ticks + after;
+		insert(node);
+		++count;
+	}
+
+	// arm node to fire after given time, rounded up to whole ticks
+	void arm(timer_node &node, std::chrono::nanoseconds after)
+	{
+		arm(node, static_cast<std::uint64_t>((after + tickLength - std::chrono::nanoseconds(1)) / tickLength));
+	}
+
+	void cancel(timer_node &node)
+	{
+		if (node.armed()) {
+			unlink(node);
+			--count;
+		}
+	}
+
+	// advance the wheel by single tick, fires all timers expiring now
+	std::size_t tick()
+	{
+		++ticks;
+
+		// entering new round of lower level, move timers of matching
+		// slot on upper level down to where they belong now
+		for (unsigned level = 1; level < levels; ++level) {
+			if (((ticks >> (level_bits * (level - 1))) & slot_mask) != 0) {
+				break;
+			}
+
+			cascade(wheel[level][(ticks >> (level_bits * level)) & slot_mask]);
+		}
+
+		return expire(wheel[0][ticks & slot_mask]);
+	}
+
+	// advance the wheel by elapsed time, remainder shorter than a tick
+	// is carried over to the next call. Returns number of fired timers.
+	std::size_t advance(std::chrono::nanoseconds elapsed)
+	{
+		pending += elapsed;
+
+		auto n = static_cast<std::uint64_t>(pending / tickLength);
+		pending -= tickLength * n;
+
+		std::size_t fired = 0;
+
+		while (n > 0 && count > 0) {
+			fired += tick();
+			--n;
+		}
+
+		// nothing to fire, just skip the time
+		ticks += n;
+		return fired;
+	}
+
+private:
+	void insert(timer_node &node)
+	{
+		const std::uint64_t delta = node.expires - ticks;
+		unsigned level = 0;
+
+		while (level + 1 < levels && delta >= (std::uint64_t(1) << (level_bits * (level + 1)))) {
+			++level;
+		}
+
+		link(node, wheel[level][(node.expires >> (level_bits * level)) & slot_mask]);
+	}
+
+	static void link(timer_node &node, timer_node &head)
+	{
+		node.prev = head.prev;
+		node.next = &head;
+		head.prev->next = &node;
+		head.prev = &node;
+	}
+
+	static void unlink(timer_node &node)
+	{
+		node.prev->next = node.next;
+		node.next->prev = node.prev;
+		node.prev = node.next = nullptr;
+	}
+
+	// move all nodes of a slot to a local list, callbacks run later may
+	// arm or cancel any timer including those still on the list
+	static void detach(timer_node &head, timer_node &local)
+	{
+		local.prev = local.next = &local;
+
+		if (head.next != &head) {
+			local.next = head.next;
+			local.prev = head.prev;
+			local.next->prev = &local;
+			local.prev->next = &local;
+			head.prev = head.next = &head;
+		}
+	}
+
+	void cascade(timer_node &head)
+	{
+		timer_node local;
+		detach(head, local);
+
+		while (local.next != &local) {
+			timer_node &node = *local.next;
+			unlink(node);
+			insert(node);
+		}
+	}
+
+	std::size_t expire(timer_node &head)
+	{
+		timer_node local;
+		detach(head, local);
+
+		std::size_t fired = 0;
+
+		while (local.next != &local) {
+			timer_node &node = *local.next;
+			unlink(node);
+			--count;
+			++fired;
+			node.fire(node);
+		}
+
+		return fired;
+	}
+
+	timer_node wheel[levels][slots];
+	std::chrono::nanoseconds tickLength;
+	std::chrono::nanoseconds pending = std::chrono::nanoseconds(0);
+	std::uint64_t ticks = 0;
+	std::size_t count = 0;
+};
+
+namespace detail
+{
+
+template<typename S>
+struct timeout_state_selector {
+	template<typename T>
+	using invoke = std::is_same<S, typename T::state_t>;
+};
+
+// timeouts of state S, at most one is allowed
+template<typename Trs, typename S>
+using state_timeouts = meta::filter<typename Trs::timeouts, timeout_state_selector<S>>;
+
+// timeouts whose state has no transition triggered by their event
+template<typename Trs>
+struct unhandled_timeout_selector {
+	template<typename T>
+	using invoke = meta::not_<meta::in<
+		typename Trs::state_events,
+		meta::list<typename T::state_t, typename T::event_t>>>;
+};
+
+// remembers whether the transition picked by dispatch is an internal
+// one, the state is not left then and its timer keeps running
+struct internal_observer
+{
+	bool internal = false;
+
+	template<typename T>
+	void selected() noexcept
+	{
+		internal = T::is_internal::value;
+	}
+};
+
+template<typename R>
+constexpr std::int64_t ratio_to_ns()
+{
+	return static_cast<std::int64_t>(R::num * 1000000000 / R::den);
+}
+
+} // namespace detail
+
+// state machine arming a timer on the shared wheel whenever a state with
+// fsm::timeout entry is entered and cancelling it when the state is left.
+// When timer expires its event is handled as any other one.
+template<typename Trs, typename Context = detail::null_context>
+class timed_fsm : public fsm<Trs, Context>, private timer_node
+{
+	using base = fsm<Trs, Context>;
+	using handler_t = bool (*)(timed_fsm &);
+
+	static_assert(meta::empty<meta::filter<typename Trs::timeouts, detail::unhandled_timeout_selector<Trs>>>::value,
+		"event of fsm::timeout has to trigger a transition from its state, "
+		"otherwise the timeout expires without any effect");
+
+public:
+	template<typename... Args>
+	explicit timed_fsm(timer_wheel &w, Args&&... args) :
+		base (std::forward<Args>(args)...),
+		wheel (w)
+	{
+		fire = &expired;
+		rearm();
+	}
+
+	~timed_fsm()
+	{
+		wheel.cancel(*this);
+	}
+
+	// handle event E, timer of new state is armed after each transition.
+	// Internal transitions leave the timer running, also when they are
+	// guarded alternatives of external ones.
+	template<typename E>
+	bool on(const E &event) noexcept(base::template nothrow_on<E>::value)
+	{
+		detail::internal_observer observer;
+
+		if (!this->onObserved(event, observer)) {
+			return false;
+		}
+
+		if (!observer.internal) {
+			rearm();
+		}
+
+		return true;
+	}
+
+	// enter initial state of lazily started machine and arm its timer
+	bool start()
+	{
+		if (!base::start()) {
+			return false;
+		}
+
+		rearm();
+		return true;
+	}
+
+	// restore state with given ID, its timer starts from the beginning
+	bool setStateById(std::size_t id)
+	{
+		if (!base::setStateById(id)) {
+			return false;
+		}
+
+		rearm();
+		return true;
+	}
+
+	// true if current state has a timer running
+	bool timerArmed() const
+	{
+		return armed();
+	}
+
+private:
+	template<typename... States>
+	static std::chrono::nanoseconds durationOf(std::size_t index, std::tuple<States...> *)
+	{
+		// last one is for machine which was not started yet
+		static const std::int64_t durations[] = {durationOfState<States>(state_timeouts<States>{})..., 0};
+		return std::chrono::nanoseconds(durations[index]);
+	}
+
+	template<typename... States>
+	static handler_t handlerOf(std::size_t index, std::tuple<States...> *)
+	{
+		static const handler_t handlers[] = {handlerOfState<States>(state_timeouts<States>{})...};
+		return handlers[index];
+	}
+
+	template<typename S>
+	using state_timeouts = detail::state_timeouts<Trs, S>;
+
+	template<typename S>
+	static constexpr std::int64_t durationOfState(meta::list<>)
+	{
+		return 0;
+	}
+
+	template<typename S, typename T>
+	static constexpr std::int64_t durationOfState(meta::list<T>)
+	{
+		return detail::ratio_to_ns<typename T::duration_t>();
+	}
+
+	template<typename S, typename T1, typename T2, typename... Ts>
+	static constexpr std::int64_t durationOfState(meta::list<T1, T2, Ts...>)
+	{
+		static_assert(!std::is_same<T1, T1>::value, "state can have only one timeout");
+		return 0;
+	}
+
+	template<typename S>
+	static constexpr handler_t handlerOfState(meta::list<>)
+	{
+		return nullptr;
+	}
+
+	template<typename S, typename T>
+	static constexpr handler_t handlerOfState(meta::list<T>)
+	{
+		return &send<typename T::event_t>;
+	}
+
+	template<typename E>
+	static bool send(timed_fsm &machine)
+	{
+		return machine.on(E{});
+	}
+
+	static void expired(timer_node &node)
+	{
+		timed_fsm &machine = static_cast<timed_fsm &>(node);
+		handlerOf(machine.currentIndex(), static_cast<typename Trs::states_tuple_t *>(nullptr))(machine);
+	}
+
+	void rearm()
+	{
+		auto after = durationOf(this->currentIndex(), static_cast<typename Trs::states_tuple_t *>(nullptr));
+
+		if (after.count() != 0) {
+			wheel.arm(*this, after);
+		} else {
+			wheel.cancel(*this);
+		}
+	}
+
+	timer_wheel &wheel;
+};
+
+} // namespace fsm
+
+#endif // FSM_TIMER_HPP
@@ -0,0 +1,419 @@
+#ifndef FSM_TYPE_LIST_HPP
+#define FSM_TYPE_LIST_HPP
+
+#include <cstddef>
+#include <type_traits>
+
+// type identity without instantiating std::is_same for every comparison
+#if defined(__has_builtin)
+#	if __has_builtin(__is_same)
+#		define FSM_META_SAME(a, b) __is_same(a, b)
+#	endif
+#endif
+
+#ifndef FSM_META_SAME
+#	define FSM_META_SAME(a, b) std::is_same<a, b>::value
+#endif
+
+// minimal type list algorithms used by the state machine, named after
+// their counterparts in ericniebler/meta. Searching and counting is done
+// by constexpr functions over arrays of flags and element access by
+// overload resolution, so neither instantiates a template per element.
+namespace fsm
+{
+namespace meta
+{
+
+constexpr std::size_t npos = std::size_t(-1);
+
+template<typename... Ts>
+struct list
+{
+	static constexpr std::size_t size()
+	{
+		return sizeof...(Ts);
+	}
+};
+
+template<bool B>
+using bool_ = std::integral_constant<bool, B>;
+
+template<std::size_t N>
+using size_t = std::integral_constant<std::size_t, N>;
+
+template<typename C, typename T, typename F>
+using if_ = typename std::conditional<C::value, T, F>::type;
+
+template<std::size_t... Is>
+struct index_sequence
+{
+	using type = index_sequence;
+
+	static constexpr std::size_t size()
+	{
+		return sizeof...(Is);
+	}
+};
+
+namespace detail
+{
+
+// counting and searching over flags, ranges are split in halves so
+// recursion depth is logarithmic
+constexpr std::size_t count_true(const bool *b, std::size_t lo, std::size_t hi)
+{
+	return hi - lo == 0 ? 0 :
+		hi - lo == 1 ? (b[lo] ? 1 : 0) :
+		count_true(b, lo, lo + (hi - lo) / 2) + count_true(b, lo + (hi - lo) / 2, hi);
+}
+
+constexpr std::size_t first_true(const bool *b, std::size_t lo, std::size_t hi);
+
+constexpr std::size_t first_true_or(std::size_t found, const bool *b, std::size_t lo, std::size_t hi)
+{
+	return found != npos ? found : first_true(b, lo, hi);
+}
+
+constexpr std::size_t first_true(const bool *b, std::size_t lo, std::size_t hi)
+{
+	return hi - lo == 0 ? npos :
+		hi - lo == 1 ? (b[lo] ? lo : npos) :
+		first_true_or(first_true(b, lo, lo + (hi - lo) / 2), b, lo + (hi - lo) / 2, hi);
+}
+
+// flags with leading false so that empty packs give valid arrays
+template<bool... Bs>
+struct flags
+{
+	static constexpr bool value[] = {false, Bs...};
+	static constexpr std::size_t count = count_true(value, 1, sizeof...(Bs) + 1);
+	static constexpr std::size_t first = first_true(value, 1, sizeof...(Bs) + 1) == npos ?
+		npos : first_true(value, 1, sizeof...(Bs) + 1) - 1;
+};
+
+template<bool... Bs>
+constexpr bool flags<Bs...>::value[];
+
+template<typename A, typename B> struct concat_sequences;
+
+template<std::size_t... As, std::size_t... Bs>
+struct concat_sequences<index_sequence<As...>, index_sequence<Bs...>>
+{
+	using type = index_sequence<As..., (sizeof...(As) + Bs)...>;
+};
+
+// sequence of N built from two halves, instantiation depth is log(N)
+template<std::size_t N>
+struct index_sequence_impl :
+	public concat_sequences<
+		typename index_sequence_impl<N / 2>::type,
+		typename index_sequence_impl<N - N / 2>::type>
+{
+};
+
+template<>
+struct index_sequence_impl<0>
+{
+	using type = index_sequence<>;
+};
+
+template<>
+struct index_sequence_impl<1>
+{
+	using type = index_sequence<0>;
+};
+
+} // namespace detail
+
+template<std::size_t N>
+using make_index_sequence = typename detail::index_sequence_impl<N>::type;
+
+template<typename... Bs>
+using and_ = bool_<detail::flags<!Bs::value...>::count == 0>;
+
+template<typename... Bs>
+using or_ = bool_<detail::flags<Bs::value...>::count != 0>;
+
+template<typename B>
+using not_ = bool_<!B::value>;
+
+// template C as metafunction class
+template<template<typename...> class C>
+struct quote
+{
+	template<typename... Ts>
+	using invoke = C<Ts...>;
+};
+
+template<typename F, typename... Ts>
+using invoke = typename F::template invoke<Ts...>;
+
+namespace detail
+{
+
+template<typename F, typename L> struct apply;
+
+template<typename F, template<typename...> class L, typename... Ts>
+struct apply<F, L<Ts...>>
+{
+	using type = invoke<F, Ts...>;
+};
+
+template<typename L> struct as_list;
+
+template<template<typename...> class L, typename... Ts>
+struct as_list<L<Ts...>>
+{
+	using type = list<Ts...>;
+};
+
+template<typename L, typename F> struct transform;
+
+template<typename... Ts, typename F>
+struct transform<list<Ts...>, F>
+{
+	using type = list<invoke<F, Ts>...>;
+};
+
+// up to eight lists are joined by single instantiation
+template<typename... Ls> struct concat;
+
+template<>
+struct concat<>
+{
+	using type = list<>;
+};
+
+template<typename... As>
+struct concat<list<As...>>
+{
+	using type = list<As...>;
+};
+
+template<typename... As, typename... Bs>
+struct concat<list<As...>, list<Bs...>>
+{
+	using type = list<As..., Bs...>;
+};
+
+template<typename... As, typename... Bs, typename... Cs, typename... Ls>
+struct concat<list<As...>, list<Bs...>, list<Cs...>, Ls...> :
+	public concat<list<As..., Bs..., Cs...>, Ls...>
+{
+};
+
+template<typename... As, typename... Bs, typename... Cs, typename... Ds,
+	typename... Es, typename... Fs, typename... Gs, typename... Hs, typename... Ls>
+struct concat<list<As...>, list<Bs...>, list<Cs...>, list<Ds...>,
+	list<Es...>, list<Fs...>, list<Gs...>, list<Hs...>, Ls...> :
+	public concat<list<As..., Bs..., Cs..., Ds..., Es..., Fs..., Gs..., Hs...>, Ls...>
+{
+};
+
+template<typename L> struct join;
+
+template<typename... Ls>
+struct join<list<Ls...>> : public concat<Ls...>
+{
+};
+
+template<typename L, typename F> struct filter;
+
+template<typename... Ts, typename F>
+struct filter<list<Ts...>, F> :
+	public concat<if_<invoke<F, Ts>, list<Ts>, list<>>...>
+{
+};
+
+template<typename L, typename T> struct count;
+
+template<typename... Ts, typename T>
+struct count<list<Ts...>, T>
+{
+	using type = size_t<flags<FSM_META_SAME(T, Ts)...>::count>;
+};
+
+template<typename L, typename T> struct find_index;
+
+template<typename... Ts, typename T>
+struct find_index<list<Ts...>, T>
+{
+	using type = size_t<flags<FSM_META_SAME(T, Ts)...>::first>;
+};
+
+// element access by overload resolution against indexed bases
+template<std::size_t I, typename T>
+struct indexed
+{
+	using type = T;
+};
+
+template<typename Is, typename... Ts> struct indexed_list;
+
+template<std::size_t... Is, typename... Ts>
+struct indexed_list<index_sequence<Is...>, Ts...> : public indexed<Is, Ts>...
+{
+};
+
+template<std::size_t I, typename T>
+indexed<I, T> select(const indexed<I, T> *);
+
+template<typename L, std::size_t N> struct at;
+
+template<typename... Ts, std::size_t N>
+struct at<list<Ts...>, N>
+{
+	static_assert(N < sizeof...(Ts), "index out of range");
+
+	using type = typename decltype(select<N>(
+		static_cast<indexed_list<make_index_sequence<sizeof...(Ts)>, Ts...> *>(nullptr)))::type;
+};
+
+// elements of L starting at position From
+template<typename L, std::size_t From, typename Is> struct drop_impl;
+
+template<typename L, std::size_t From, std::size_t... Is>
+struct drop_impl<L, From, index_sequence<Is...>>
+{
+	using type = list<typename at<L, From + Is>::type...>;
+};
+
+template<typename L, typename F> struct find_if;
+
+template<typename... Ts, typename F>
+struct find_if<list<Ts...>, F>
+{
+	static constexpr std::size_t first = flags<invoke<F, Ts>::value...>::first;
+	static constexpr std::size_t from = first == npos ? sizeof...(Ts) : first;
+
+	using type = typename drop_impl<
+		list<Ts...>, from, make_index_sequence<sizeof...(Ts) - from>>::type;
+};
+
+// element stays if it is the first of its kind
+template<typename L, typename Is> struct unique_impl;
+
+template<typename... Ts, std::size_t... Is>
+struct unique_impl<list<Ts...>, index_sequence<Is...>> :
+	public concat<if_<
+		bool_<find_index<list<Ts...>, Ts>::type::value == Is>,
+		list<Ts>,
+		list<>>...>
+{
+};
+
+template<typename L> struct unique;
+
+template<typename... Ts>
+struct unique<list<Ts...>> :
+	public unique_impl<list<Ts...>, make_index_sequence<sizeof...(Ts)>>
+{
+};
+
+template<typename L> struct front;
+
+template<typename T, typename... Ts>
+struct front<list<T, Ts...>>
+{
+	using type = T;
+};
+
+template<typename L, typename T> struct push_back;
+
+template<typename... Ts, typename T>
+struct push_back<list<Ts...>, T>
+{
+	using type = list<Ts..., T>;
+};
+
+template<typename L, typename T> struct push_front;
+
+template<typename... Ts, typename T>
+struct push_front<list<Ts...>, T>
+{
+	using type = list<T, Ts...>;
+};
+
+// left fold, the only operation which has to go element by element
+template<typename L, typename S, typename F> struct fold;
+
+template<typename S, typename F>
+struct fold<list<>, S, F>
+{
+	using type = S;
+};
+
+template<typename T, typename... Ts, typename S, typename F>
+struct fold<list<T, Ts...>, S, F> : public fold<list<Ts...>, invoke<F, S, T>, F>
+{
+};
+
+} // namespace detail
+
+// F invoked with elements of L, L can be any variadic template
+template<typename F, typename L>
+using apply = typename detail::apply<F, L>::type;
+
+template<typename L>
+using as_list = typename detail::as_list<L>::type;
+
+template<typename L, typename F>
+using transform = typename detail::transform<L, F>::type;
+
+template<typename... Ls>
+using concat = typename detail::concat<Ls...>::type;
+
+template<typename L>
+using join = typename detail::join<L>::type;
+
+// elements T of L for which F::invoke<T> is true
+template<typename L, typename F>
+using filter = typename detail::filter<L, F>::type;
+
+// L without repeated elements, first occurrences are kept in order
+template<typename L>
+using unique = typename detail::unique<L>::type;
+
+template<typename L, typename T>
+using count = typename detail::count<L, T>::type;
+
+// position of the first T in L, npos if there is none
+template<typename L, typename T>
+using find_index = typename detail::find_index<L, T>::type;
+
+// tail of L starting with the first T for which F::invoke<T> is true,
+// empty list if there is none
+template<typename L, typename F>
+using find_if = typename detail::find_if<L, F>::type;
+
+template<typename L, typename T>
+using in = bool_<detail::count<L, T>::type::value != 0>;
+
+template<typename L, std::size_t N>
+using at_c = typename detail::at<L, N>::type;
+
+template<typename L, typename N>
+using at = typename detail::at<L, N::value>::type;
+
+template<typename L>
+using front = typename detail::front<L>::type;
+
+template<typename L>
+using size = size_t<L::size()>;
+
+template<typename L>
+using empty = bool_<L::size() == 0>;
+
+template<typename L, typename T>
+using push_back = typename detail::push_back<L, T>::type;
+
+template<typename L, typename T>
+using push_front = typename detail::push_front<L, T>::type;
+
+template<typename L, typename S, typename F>
+using fold = typename detail::fold<L, S, F>::type;
+
+} // namespace meta
+} // namespace fsm
+
+#endif // FSM_TYPE_LIST_HPP
@@ -0,0 +1,203 @@
+#include <fsm/export.hpp>
+#include "catch.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+struct Coin {
+	static constexpr const char *name = "Coin";
+	int value;
+};
+
+struct Push { static constexpr const char *name = "Push"; };
+
+struct Context {
+	int credit = 0;
+	int passed = 0;
+	int price = 2;
+	std::string log;
+};
+
+/* states have no behavior of their own, it is all in the table */
+struct Locked : public fsm::empty_state<1> {};
+struct Unlocked : public fsm::empty_state<2> {};
+
+struct Enough {
+	static constexpr const char *name = "Enough";
+	bool operator()(Context &ctx, const Coin &c) const { return ctx.credit + c.value >= ctx.price; }
+};
+
+/* shared by every transition triggered by Coin */
+struct Count {
+	static constexpr const char *name = "Count";
+	void operator()(Context &ctx, const Coin &c) const { ctx.credit += c.value; }
+};
+
+struct Pass {
+	static constexpr const char *name = "Pass";
+	void operator()(Context &ctx, const Push &) const { ctx.credit = 0; ++ctx.passed; }
+};
+
+using table = fsm::transitions<
+	fsm::transition<Locked, Coin, Unlocked, Enough, Count>,
+	fsm::internal<Locked, Coin, void, Count>,
+	fsm::internal<Unlocked, Coin, void, Count>,
+	fsm::transition<Unlocked, Push, Locked, void, Pass>
+>;
+
+using machine = fsm::fsm<table, Context>;
+
+/* hooks record the order in which they are called */
+struct Logged : public fsm::state<3>
+{
+	Logged(Context &ctx) : ctx_(ctx) {}
+
+	void enter() { ctx_.log += "enter "; }
+	void exit() { ctx_.log += "exit "; }
+
+	bool event(const Push &) { ctx_.log += "event "; return true; }
+
+	Context &ctx_;
+};
+
+struct Log {
+	void operator()(Context &ctx, const Push &) const { ctx.log += "action "; }
+};
+
+struct Fail {
+	void operator()(Context &, const Push &) const { throw std::runtime_error("action"); }
+};
+
+/* the context is not needed without context */
+int pushed = 0;
+
+struct Pushed {
+	void operator()(const Push &) const noexcept { ++pushed; }
+};
+
+struct Plain : public fsm::empty_state<1> {};
+
+using plain_machine = fsm::fsm<fsm::transitions<
+	fsm::transition<Plain, Push, Plain, void, Pushed>
+>>;
+
+/* flyweight machines pass their own context */
+struct Shared {
+	int credit = 0;
+};
+
+struct Add {
+	void operator()(Shared &ctx, const Coin &c) const { ctx.credit += c.value; }
+};
+
+using flyweight_machine = fsm::fsm<fsm::transitions<
+	fsm::internal<Locked, Coin, void, Add>,
+	fsm::transition<Locked, Push, Unlocked>
+>, fsm::flyweight<Shared>>;
+
+struct Same : public fsm::empty_state<4> { using behavior_free = std::true_type; };
+struct Other : public fsm::empty_state<5> { using behavior_free = std::true_type; };
+struct Last : public fsm::empty_state<6> { using behavior_free = std::true_type; };
+
+/* Same and Other differ only by the action of Push */
+using mergeable_table = fsm::transitions<
+	fsm::transition<Same, Coin, Other>,
+	fsm::transition<Same, Push, Last>,
+	fsm::transition<Other, Coin, Other>,
+	fsm::transition<Other, Push, Last, void, Pushed>,
+	fsm::transition<Last, Coin, Same>
+>;
+
+}
+
+TEST_CASE("Actions of the table update the context", "[fsm]")
+{
+	static_assert(std::is_empty<Locked>::value && std::is_empty<Unlocked>::value, "empty states");
+
+	Context ctx;
+	machine m(ctx);
+
+	REQUIRE(m.on(Coin{1}));
+	REQUIRE(m.currentState() == 1);
+	REQUIRE(ctx.credit == 1);
+
+	/* Enough sees credit before Count adds the coin */
+	REQUIRE(m.on(Coin{1}));
+	REQUIRE(m.currentState() == 2);
+	REQUIRE(ctx.credit == 2);
+
+	REQUIRE(m.on(Coin{5}));
+	REQUIRE(ctx.credit == 7);
+
+	REQUIRE(m.on(Push{}));
+	REQUIRE(m.currentState() == 1);
+	REQUIRE(ctx.credit == 0);
+	REQUIRE(ctx.passed == 1);
+}
+
+TEST_CASE("Action runs between exit() and enter()", "[fsm]")
+{
+	Context ctx;
+	fsm::fsm<fsm::transitions<
+		fsm::transition<Logged, Push, Logged, void, Log>
+	>, Context> m(ctx);
+
+	ctx.log.clear();
+	REQUIRE(m.on(Push{}));
+	REQUIRE(ctx.log == "event exit action enter ");
+}
+
+TEST_CASE("Throwing action enters the start state again", "[fsm]")
+{
+	Context ctx;
+	fsm::fsm<fsm::transitions<
+		fsm::transition<Logged, Push, Locked, void, Fail>
+	>, Context> m(ctx);
+
+	ctx.log.clear();
+	REQUIRE_THROWS_AS(m.on(Push{}), std::runtime_error &);
+	REQUIRE(m.currentState() == 3);
+	REQUIRE(ctx.log == "event exit enter ");
+}
+
+TEST_CASE("Actions without context", "[fsm]")
+{
+	static_assert(plain_machine::nothrow_on<Push>::value, "noexcept action and default hooks");
+	static_assert(!machine::nothrow_on<Push>::value, "action may throw");
+	static_assert(sizeof(plain_machine) == sizeof(plain_machine::index_t), "no context is kept");
+
+	plain_machine m;
+
+	pushed = 0;
+	REQUIRE(m.on(Push{}));
+	REQUIRE(m.on(Push{}));
+	REQUIRE(pushed == 2);
+}
+
+TEST_CASE("Actions of flyweight machine get its context", "[fsm]")
+{
+	flyweight_machine m;
+
+	REQUIRE(m.on(Coin{3}));
+	REQUIRE(m.on(Coin{4}));
+	REQUIRE(m.currentState() == 1);
+	REQUIRE(m.context().credit == 7);
+}
+
+TEST_CASE("Actions are kept by minimize and shown by exporters", "[fsm]")
+{
+	static_assert(fsm::minimize<mergeable_table>::states_count::value == 3, "states with actions are not merged");
+
+	std::ostringstream dot;
+	fsm::write_dot<table>(dot);
+	REQUIRE(dot.str().find("s0 -> s1 [label=\"Coin [Enough] / Count\"];") != std::string::npos);
+	REQUIRE(dot.str().find("s1 -> s0 [label=\"Push / Pass\"];") != std::string::npos);
+
+	std::ostringstream json;
+	fsm::write_json<table>(json);
+	REQUIRE(json.str().find("\"guard\":\"Enough\",\"action\":\"Count\"") != std::string::npos);
+}
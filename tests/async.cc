@@ -0,0 +1,304 @@
+#include <fsm/async.hpp>
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+/* counts every allocation of the test binary */
+static std::size_t allocations = 0;
+
+void *operator new(std::size_t n)
+{
+	++allocations;
+
+	if (void *p = std::malloc(n ? n : 1)) {
+		return p;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+
+struct Connect {};
+struct Connected {};
+struct Close {};
+
+struct Dial {
+	bool direct;
+};
+
+/* guards of transitions are synchronous */
+struct Direct {
+	bool operator()(const Dial &d) const { return d.direct; }
+};
+
+/* Stand-in for asynchronous I/O, completed by the test itself */
+struct io_operation
+{
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> h) noexcept { waiting = h; }
+	void await_resume() noexcept {}
+
+	static std::coroutine_handle<> waiting;
+
+	static void complete()
+	{
+		auto h = std::exchange(waiting, nullptr);
+		h.resume();
+	}
+};
+
+std::coroutine_handle<> io_operation::waiting;
+
+struct Idle : public fsm::state<1>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Connect &) { return true; }
+	bool event(const Dial &) { return true; }
+};
+
+struct Connecting : public fsm::state<2>
+{
+	/* entering this state waits for I/O */
+	fsm::task<> enter()
+	{
+		co_await io_operation{};
+	}
+
+	void exit() {}
+
+	bool event(const Connect &) { return true; }
+	bool event(const Connected &) { return true; }
+};
+
+struct Up : public fsm::state<3>
+{
+	void enter() {}
+	void exit() {}
+
+	/* guard may be asynchronous too */
+	fsm::task<bool> event(const Close &)
+	{
+		co_await io_operation{};
+		co_return true;
+	}
+};
+
+using transition_table = fsm::transitions<
+	fsm::transition<Idle, Connect, Connecting>,
+	fsm::transition<Connecting, Connected, Up>,
+	fsm::transition<Up, Close, Idle>
+>;
+
+using guarded_table = fsm::transitions<
+	fsm::transition<Idle, Dial, Up, Direct>,
+	fsm::transition<Idle, Dial, Connecting>,
+	fsm::transition<Connecting, Connected, Up>,
+	fsm::transition<Up, Close, Idle>
+>;
+
+/* actions are synchronous */
+int retries = 0;
+
+struct Retry {
+	void operator()(const Connect &) const { ++retries; }
+};
+
+/* hooks throwing in synchronous and asynchronous transitions */
+struct Trouble {};
+
+int fragileEntered = 0;
+
+struct Fragile : public fsm::state<4>
+{
+	void enter() { ++fragileEntered; }
+	void exit() {}
+
+	bool event(const Trouble &) { throw std::runtime_error("event"); }
+	bool event(const Close &) { throw std::runtime_error("event"); }
+	bool event(const Connect &) { return true; }
+};
+
+struct Failing : public fsm::state<5>
+{
+	fsm::task<> enter()
+	{
+		co_await io_operation{};
+		throw std::runtime_error("enter");
+	}
+
+	void exit() {}
+};
+
+using failing_table = fsm::transitions<
+	fsm::transition<Fragile, Trouble, Idle>,
+	fsm::transition<Fragile, Close, Failing>,
+	fsm::transition<Fragile, Connect, Failing>
+>;
+
+/* repeated Connect doesn't enter Connecting again */
+using internal_table = fsm::transitions<
+	fsm::transition<Idle, Connect, Connecting>,
+	fsm::internal<Connecting, Connect, void, Retry>,
+	fsm::transition<Connecting, Connected, Up>,
+	fsm::transition<Up, Close, Idle>
+>;
+
+}
+
+TEST_CASE("Asynchronous enter with queued events", "[fsm][async]")
+{
+	fsm::manual_executor executor;
+	fsm::async_fsm<transition_table> sm(executor);
+
+	REQUIRE(sm.currentState() == 1);
+	REQUIRE_FALSE(sm.inTransition());
+
+	REQUIRE(sm.on(Connect{}));
+	REQUIRE(sm.inTransition());
+	REQUIRE(sm.currentState() == 1);
+
+	/* arrives during transition, handled once it is done */
+	REQUIRE(sm.on(Connected{}));
+	REQUIRE(executor.run() == 0);
+
+	io_operation::complete();
+	REQUIRE(sm.inTransition());
+
+	executor.run();
+	REQUIRE_FALSE(sm.inTransition());
+	REQUIRE(sm.currentState() == 3);
+}
+
+TEST_CASE("Asynchronous guard", "[fsm][async]")
+{
+	fsm::manual_executor executor;
+	fsm::async_fsm<transition_table> sm(executor);
+
+	sm.on(Connect{});
+	io_operation::complete();
+	executor.run();
+	sm.on(Connected{});
+	REQUIRE(sm.currentState() == 3);
+
+	REQUIRE(sm.on(Close{}));
+	REQUIRE(sm.inTransition());
+	io_operation::complete();
+	executor.run();
+
+	REQUIRE_FALSE(sm.inTransition());
+	REQUIRE(sm.currentState() == 1);
+}
+
+TEST_CASE("Events rejected during asynchronous transition", "[fsm][async]")
+{
+	fsm::manual_executor executor;
+	fsm::async_fsm<transition_table, fsm::detail::null_context,
+		fsm::manual_executor, fsm::reject_events> sm(executor);
+
+	REQUIRE(sm.on(Connect{}));
+	REQUIRE_FALSE(sm.on(Connected{}));
+
+	io_operation::complete();
+	executor.run();
+	REQUIRE(sm.currentState() == 2);
+
+	/* variant of all events can be dispatched too */
+	using event_t = decltype(sm)::event_t;
+	REQUIRE(sm.on(event_t{Connected{}}));
+	REQUIRE(sm.currentState() == 3);
+}
+
+TEST_CASE("Guarded alternatives of asynchronous machine", "[fsm][async]")
+{
+	fsm::manual_executor executor;
+	fsm::async_fsm<guarded_table> sm(executor);
+
+	REQUIRE(sm.on(Dial{true}));
+	REQUIRE_FALSE(sm.inTransition());
+	REQUIRE(sm.currentState() == 3);
+
+	REQUIRE(sm.on(Close{}));
+	io_operation::complete();
+	executor.run();
+	REQUIRE(sm.currentState() == 1);
+
+	REQUIRE(sm.on(Dial{false}));
+	REQUIRE(sm.inTransition());
+	io_operation::complete();
+	executor.run();
+	REQUIRE(sm.currentState() == 2);
+}
+
+TEST_CASE("Internal transition of asynchronous machine", "[fsm][async]")
+{
+	fsm::manual_executor executor;
+	fsm::async_fsm<internal_table> sm(executor);
+
+	REQUIRE(sm.on(Connect{}));
+	io_operation::complete();
+	executor.run();
+	REQUIRE(sm.currentState() == 2);
+
+	REQUIRE(sm.on(Connect{}));
+	REQUIRE_FALSE(sm.inTransition());
+	REQUIRE(io_operation::waiting == nullptr);
+	REQUIRE(sm.currentState() == 2);
+	REQUIRE(retries == 1);
+}
+
+TEST_CASE("Hook throwing during asynchronous machine transition", "[fsm][async]")
+{
+	fsm::manual_executor executor;
+	fsm::async_fsm<failing_table> sm(executor);
+
+	/* synchronous transition, thrown right away */
+	REQUIRE_THROWS_AS(sm.on(Trouble{}), std::runtime_error &);
+	REQUIRE_FALSE(sm.inTransition());
+	REQUIRE(sm.currentState() == 4);
+
+	/* asynchronous one failing before it suspends, thrown by on() too */
+	REQUIRE_THROWS_AS(sm.on(Close{}), std::runtime_error &);
+	REQUIRE_FALSE(sm.inTransition());
+
+	/* enter() failing after it resumed, the source state is entered again
+	 * and the exception is thrown by the executor */
+	fragileEntered = 0;
+	REQUIRE(sm.on(Connect{}));
+	REQUIRE(sm.inTransition());
+
+	io_operation::complete();
+	REQUIRE_THROWS_AS(executor.run(), std::runtime_error &);
+	REQUIRE_FALSE(sm.inTransition());
+	REQUIRE(sm.currentState() == 4);
+	REQUIRE(fragileEntered == 1);
+}
+
+TEST_CASE("Synchronous transition of asynchronous machine doesn't allocate", "[fsm][async]")
+{
+	fsm::manual_executor executor;
+	fsm::async_fsm<guarded_table> sm(executor);
+
+	const std::size_t before = allocations;
+	const bool taken = sm.on(Dial{true});
+	const std::size_t made = allocations - before;
+
+	REQUIRE(taken);
+	REQUIRE(made == 0);
+	REQUIRE(sm.currentState() == 3);
+}
@@ -0,0 +1,99 @@
+#include <fsm.hpp>
+#include "catch.hpp"
+
+namespace
+{
+
+struct Open {};
+struct Close {};
+struct Lock {};
+struct Unknown {};
+
+template<std::size_t ID>
+struct Door : public fsm::state<ID>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Open &) { return true; }
+	bool event(const Close &) { return true; }
+	bool event(const Lock &) { return false; }
+};
+
+using machine = fsm::fsm<fsm::transitions<
+	fsm::transition<Door<1>, Open, Door<2>>,
+	fsm::transition<Door<1>, Lock, Door<3>>,
+	fsm::transition<Door<2>, Close, Door<1>>,
+	fsm::transition<Door<3>, Open, Door<1>>
+>>;
+
+/* more events than fit a single word of the mask */
+template<std::size_t N>
+struct Ev {};
+
+template<std::size_t ID>
+struct Wide : public fsm::state<ID>
+{
+	void enter() {}
+	void exit() {}
+
+	template<typename E>
+	bool event(const E &) { return true; }
+};
+
+template<std::size_t... Is>
+fsm::transitions<
+	fsm::transition<Wide<0>, Ev<Is>, Wide<1>>...,
+	fsm::transition<Wide<1>, Ev<69>, Wide<0>>
+> make_wide(fsm::meta::index_sequence<Is...>);
+
+using wide_machine = fsm::fsm<decltype(make_wide(fsm::meta::make_index_sequence<69>{}))>;
+
+}
+
+TEST_CASE("Events handled by current state", "[fsm]")
+{
+	machine m;
+
+	REQUIRE(m.canHandle<Open>());
+	REQUIRE(m.canHandle<Lock>());
+	REQUIRE_FALSE(m.canHandle<Close>());
+	REQUIRE_FALSE(m.canHandle<Unknown>());
+
+	REQUIRE(m.on(Open{}));
+	REQUIRE(m.canHandle<Close>());
+	REQUIRE_FALSE(m.canHandle<Open>());
+	REQUIRE_FALSE(m.canHandle<Lock>());
+
+	/* transition exists even though event() rejects it */
+	REQUIRE(m.on(Close{}));
+	REQUIRE(m.canHandle<Lock>());
+	REQUIRE_FALSE(m.on(Lock{}));
+}
+
+TEST_CASE("Nothing is handled before start", "[fsm]")
+{
+	machine m(fsm::lazy_start);
+
+	REQUIRE_FALSE(m.canHandle<Open>());
+	REQUIRE_FALSE(m.canHandle<Lock>());
+
+	m.start();
+	REQUIRE(m.canHandle<Open>());
+}
+
+TEST_CASE("Handled events spanning several mask words", "[fsm]")
+{
+	wide_machine m;
+
+	REQUIRE(m.canHandle<Ev<0>>());
+	REQUIRE(m.canHandle<Ev<63>>());
+	REQUIRE(m.canHandle<Ev<64>>());
+	REQUIRE(m.canHandle<Ev<68>>());
+	REQUIRE_FALSE(m.canHandle<Ev<69>>());
+
+	REQUIRE(m.on(Ev<64>{}));
+	REQUIRE_FALSE(m.canHandle<Ev<0>>());
+	REQUIRE_FALSE(m.canHandle<Ev<64>>());
+	REQUIRE(m.canHandle<Ev<69>>());
+}
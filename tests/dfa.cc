@@ -0,0 +1,147 @@
+#include <fsm/dfa.hpp>
+#include "catch.hpp"
+
+#include <random>
+#include <string>
+
+namespace
+{
+
+using letter = fsm::char_range<'a', 'z'>;
+using digit = fsm::char_range<'0', '9'>;
+using space = fsm::chars<' ', '\t', '\n'>;
+
+template<std::size_t ID>
+struct S : public fsm::state<ID> {};
+
+using Start = S<0>;
+using Ident = S<1>;
+using Number = S<2>;
+using Space = S<3>;
+
+/* numbers followed by a letter are rejected, other bytes go back to start */
+using table = fsm::transitions<
+	fsm::transition<Start, letter, Ident>,
+	fsm::transition<Start, digit, Number>,
+	fsm::transition<Start, space, Space>,
+	fsm::transition<Start, fsm::other_bytes, Start>,
+	fsm::transition<Ident, letter, Ident>,
+	fsm::transition<Ident, digit, Ident>,
+	fsm::transition<Ident, space, Space>,
+	fsm::transition<Ident, fsm::other_bytes, Start>,
+	fsm::transition<Number, digit, Number>,
+	fsm::transition<Number, space, Space>,
+	fsm::transition<Space, space, Space>,
+	fsm::transition<Space, letter, Ident>,
+	fsm::transition<Space, digit, Number>,
+	fsm::transition<Space, fsm::other_bytes, Start>
+>;
+
+using dfa = fsm::dfa<table>;
+
+/* byte at a time by the table, as written above */
+std::size_t reference(const std::string &s, std::size_t &state)
+{
+	for (std::size_t i = 0; i < s.size(); ++i) {
+		const unsigned char c = static_cast<unsigned char>(s[i]);
+		const bool isLetter = c >= 'a' && c <= 'z';
+		const bool isDigit = c >= '0' && c <= '9';
+		const bool isSpace = c == ' ' || c == '\t' || c == '\n';
+
+		switch (state) {
+		case 0:
+		case 3:
+			state = isLetter ? 1 : isDigit ? 2 : isSpace ? 3 : 0;
+			break;
+		case 1:
+			state = isLetter || isDigit ? 1 : isSpace ? 3 : 0;
+			break;
+		case 2:
+			if (isLetter || !(isDigit || isSpace)) {
+				return i;
+			}
+			state = isDigit ? 2 : 3;
+			break;
+		}
+	}
+
+	return s.size();
+}
+
+}
+
+TEST_CASE("Bytes are mapped to classes", "[fsm]")
+{
+	dfa m;
+
+	REQUIRE(m.currentState() == 0);
+	REQUIRE(dfa::step(0, 'q') == 1);
+	REQUIRE(dfa::step(0, '7') == 2);
+	REQUIRE(dfa::step(0, '\t') == 3);
+	REQUIRE(dfa::step(0, '#') == 0);
+	REQUIRE(dfa::step(0, 0xff) == 0);
+	REQUIRE(dfa::step(2, 'q') == dfa::reject);
+	REQUIRE(dfa::step(2, '#') == dfa::reject);
+
+	REQUIRE(m.feed("abc12 ") == 6);
+	REQUIRE(m.currentState() == 3);
+
+	/* the rejected byte is not consumed */
+	REQUIRE(m.feed("42x") == 2);
+	REQUIRE(m.currentState() == 2);
+	REQUIRE(m.feed("x") == 0);
+	REQUIRE(m.feed("") == 0);
+	REQUIRE(m.currentState() == 2);
+
+	m.reset();
+	REQUIRE(m.currentState() == 0);
+	REQUIRE(m.setStateById(1));
+	REQUIRE(m.currentIndex() == 1);
+	REQUIRE_FALSE(m.setStateById(7));
+	REQUIRE(m.currentIndex() == 1);
+}
+
+TEST_CASE("Long runs keeping the state", "[fsm]")
+{
+	/* runs crossing whole vectors, left at every offset */
+	for (std::size_t run = 0; run < 70; ++run) {
+		for (const char *tail : {"", " ", "x", "#a"}) {
+			dfa m;
+			std::size_t state = 0;
+
+			const std::string word = "a" + std::string(run, 'z') + tail;
+			REQUIRE(m.feed(word) == reference(word, state));
+			REQUIRE(m.currentState() == state);
+
+			const std::string number = "1" + std::string(run, '9') + tail + "1";
+			m.reset();
+			state = 0;
+			REQUIRE(m.feed(number) == reference(number, state));
+			REQUIRE(m.currentState() == state);
+		}
+	}
+}
+
+TEST_CASE("Random input matches the table", "[fsm]")
+{
+	const std::string alphabet = "abcxyz0123456789 \t\n#!\x80\xff";
+
+	std::mt19937 gen(11);
+	std::uniform_int_distribution<std::size_t> pick(0, alphabet.size() - 1);
+	std::uniform_int_distribution<std::size_t> length(0, 40);
+
+	for (std::size_t k = 0; k < 2000; ++k) {
+		std::string input;
+
+		/* runs of a single byte class to exercise skipping */
+		while (input.size() < 300) {
+			input.append(length(gen), alphabet[pick(gen)]);
+		}
+
+		dfa m;
+		std::size_t state = 0;
+
+		REQUIRE(m.feed(input) == reference(input, state));
+		REQUIRE(m.currentState() == state);
+	}
+}
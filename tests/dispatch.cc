@@ -0,0 +1,94 @@
+#include <fsm.hpp>
+#include "catch.hpp"
+
+namespace
+{
+
+struct Next {};
+struct Jump {};
+
+/* Ring of states, each one moves to the next on Next event */
+template<std::size_t ID>
+struct Ring : public fsm::state<ID>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Next &) { return true; }
+	bool event(const Jump &) { return true; }
+};
+
+using transition_table = fsm::transitions<
+	fsm::transition<Ring<1>, Next, Ring<2>>,
+	fsm::transition<Ring<2>, Next, Ring<3>>,
+	fsm::transition<Ring<3>, Next, Ring<4>>,
+	fsm::transition<Ring<4>, Next, Ring<5>>,
+	fsm::transition<Ring<5>, Next, Ring<6>>,
+	fsm::transition<Ring<6>, Next, Ring<7>>,
+	fsm::transition<Ring<7>, Next, Ring<8>>,
+	fsm::transition<Ring<8>, Next, Ring<9>>,
+	fsm::transition<Ring<9>, Next, Ring<1>>,
+
+	/* only one state handles Jump */
+	fsm::transition<Ring<5>, Jump, Ring<1>>
+>;
+
+}
+
+TEST_CASE("Dispatch over many candidate states", "[fsm]")
+{
+	fsm::fsm<transition_table> sm;
+
+	for (std::size_t i = 0; i < 18; ++i) {
+		REQUIRE(sm.currentState() == i % 9 + 1);
+		REQUIRE(sm.on(Next{}));
+	}
+
+	REQUIRE(sm.currentState() == 1);
+}
+
+TEST_CASE("Dispatch to single candidate state", "[fsm]")
+{
+	fsm::fsm<transition_table> sm;
+
+	REQUIRE(sm.on(Jump{}) == false);
+	REQUIRE(sm.currentState() == 1);
+
+	for (int i = 0; i < 4; ++i) {
+		sm.on(Next{});
+	}
+
+	REQUIRE(sm.currentState() == 5);
+	REQUIRE(sm.on(Jump{}));
+	REQUIRE(sm.currentState() == 1);
+}
+
+TEST_CASE("Dispatch with hot transitions", "[fsm]")
+{
+	/* marking transitions as hot changes only order of checks */
+	using hot_table = fsm::transitions<
+		fsm::transition<Ring<1>, Next, Ring<2>>,
+		fsm::transition<Ring<2>, Next, Ring<3>>,
+		fsm::hot<fsm::transition<Ring<3>, Next, Ring<4>>, 10>,
+		fsm::transition<Ring<4>, Next, Ring<5>>,
+		fsm::transition<Ring<5>, Next, Ring<6>>,
+		fsm::hot<fsm::transition<Ring<6>, Next, Ring<1>>, 1000>,
+		fsm::hot<fsm::transition<Ring<5>, Jump, Ring<1>>>
+	>;
+
+	fsm::fsm<hot_table> sm;
+
+	for (std::size_t i = 0; i < 12; ++i) {
+		REQUIRE(sm.currentState() == i % 6 + 1);
+		REQUIRE(sm.on(Next{}));
+	}
+
+	for (int i = 0; i < 4; ++i) {
+		REQUIRE(sm.on(Jump{}) == false);
+		sm.on(Next{});
+	}
+
+	REQUIRE(sm.currentState() == 5);
+	REQUIRE(sm.on(Jump{}));
+	REQUIRE(sm.currentState() == 1);
+}
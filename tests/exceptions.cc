@@ -0,0 +1,128 @@
+#include <fsm.hpp>
+#include <stdexcept>
+#include "catch.hpp"
+
+namespace
+{
+
+struct Step {};
+struct Fail {};
+
+struct Context {
+	int entered[3] = {};
+	int exited[3] = {};
+	/* ID of state which enter() throws */
+	std::size_t failEnter = 3;
+	bool failEvent = false;
+};
+
+template<std::size_t ID>
+struct Safe : public fsm::state<ID>
+{
+	Safe(Context &) {}
+
+	void enter() noexcept {}
+	void exit() noexcept {}
+
+	bool event(const Step &) noexcept { return true; }
+	bool event(const Fail &) noexcept { return true; }
+};
+
+template<std::size_t ID>
+struct Risky : public fsm::state<ID>
+{
+	Risky(Context &ctx) : ctx_(ctx) {}
+
+	void enter()
+	{
+		if (ctx_.failEnter == ID) {
+			throw std::runtime_error("enter");
+		}
+
+		++ctx_.entered[ID];
+	}
+
+	void exit() { ++ctx_.exited[ID]; }
+
+	bool event(const Step &)
+	{
+		if (ctx_.failEvent) {
+			throw std::runtime_error("event");
+		}
+
+		return true;
+	}
+
+	bool event(const Fail &) { return true; }
+
+	Context &ctx_;
+};
+
+using safe_table = fsm::transitions<
+	fsm::transition<Safe<0>, Step, Safe<1>>,
+	fsm::transition<Safe<1>, Step, Safe<0>>
+>;
+
+/* Fail is handled only by noexcept hooks */
+using mixed_table = fsm::transitions<
+	fsm::transition<Risky<0>, Step, Risky<1>>,
+	fsm::transition<Risky<1>, Step, Risky<0>>,
+	fsm::transition<Risky<1>, Fail, Safe<2>>,
+	fsm::transition<Safe<2>, Fail, Safe<2>>
+>;
+
+}
+
+TEST_CASE("noexcept dispatch", "[fsm]")
+{
+	Context ctx;
+	fsm::fsm<safe_table, Context> safe(ctx);
+	fsm::fsm<mixed_table, Context> mixed(ctx);
+
+	static_assert(noexcept(safe.on(Step{})), "all hooks are noexcept");
+	static_assert(noexcept(safe.start()), "enter() is noexcept");
+	static_assert(!noexcept(mixed.on(Step{})), "hooks handling Step may throw");
+	static_assert(!noexcept(mixed.on(Fail{})), "exit() of Risky<1> may throw");
+	static_assert(fsm::fsm<mixed_table, Context>::nothrow_on<Step>::value == false, "");
+
+	REQUIRE(safe.on(Step{}));
+	REQUIRE(safe.currentState() == 1);
+}
+
+TEST_CASE("Exception from event() leaves machine as it was", "[fsm]")
+{
+	Context ctx;
+	fsm::fsm<mixed_table, Context> sm(ctx);
+	REQUIRE(ctx.entered[0] == 1);
+
+	ctx.failEvent = true;
+	REQUIRE_THROWS(sm.on(Step{}));
+	REQUIRE(sm.currentState() == 0);
+	REQUIRE(ctx.exited[0] == 0);
+
+	ctx.failEvent = false;
+	REQUIRE(sm.on(Step{}));
+	REQUIRE(sm.currentState() == 1);
+}
+
+TEST_CASE("Failed enter() rolls back to the start state", "[fsm]")
+{
+	Context ctx;
+	fsm::fsm<mixed_table, Context> sm(ctx);
+
+	REQUIRE(sm.on(Step{}));
+	REQUIRE(ctx.entered[1] == 1);
+
+	/* Risky<0> can't be entered, Risky<1> is entered again */
+	ctx.failEnter = 0;
+	REQUIRE_THROWS(sm.on(Step{}));
+	ctx.failEnter = 3;
+
+	REQUIRE(sm.currentState() == 1);
+	REQUIRE(ctx.exited[1] == 1);
+	REQUIRE(ctx.entered[0] == 1);
+	REQUIRE(ctx.entered[1] == 2);
+
+	REQUIRE(sm.on(Step{}));
+	REQUIRE(sm.currentState() == 0);
+}
@@ -0,0 +1,121 @@
+#include <fsm/export.hpp>
+#include <sstream>
+#include "catch.hpp"
+
+namespace
+{
+
+struct Next { static constexpr const char *name = "Next"; };
+struct Reset { static constexpr const char *name = "Reset"; };
+
+struct Context {
+	bool allow = true;
+};
+
+template<std::size_t ID>
+struct S : public fsm::state<ID>
+{
+	S(Context &ctx) : ctx_(ctx) {}
+
+	void enter() {}
+	void exit() {}
+
+	bool event(const Next &) { return ctx_.allow; }
+	bool event(const Reset &) { return true; }
+
+	Context &ctx_;
+};
+
+using table = fsm::transitions<
+	fsm::transition<S<10>, Next, S<20>>,
+	fsm::hot<fsm::transition<S<20>, Next, S<30>>>,
+	fsm::transition<S<30>, Reset, S<10>>
+>;
+
+}
+
+TEST_CASE("Export to DOT", "[fsm]")
+{
+	std::ostringstream out;
+	fsm::write_dot<table>(out, "ring");
+
+	REQUIRE(out.str() ==
+		"digraph \"ring\" {\n"
+		"\ts0 [label=\"10\", shape=doublecircle];\n"
+		"\ts1 [label=\"20\"];\n"
+		"\ts2 [label=\"30\"];\n"
+		"\ts0 -> s1 [label=\"Next\"];\n"
+		"\ts1 -> s2 [label=\"Next\", style=bold];\n"
+		"\ts2 -> s0 [label=\"Reset\"];\n"
+		"}\n");
+}
+
+TEST_CASE("Export to JSON", "[fsm]")
+{
+	std::ostringstream out;
+	fsm::write_json<table>(out);
+
+	REQUIRE(out.str() ==
+		"{\"states\":["
+		"{\"index\":0,\"id\":10,\"initial\":true},"
+		"{\"index\":1,\"id\":20,\"initial\":false},"
+		"{\"index\":2,\"id\":30,\"initial\":false}],"
+		"\"transitions\":["
+		"{\"from\":0,\"to\":1,\"event\":\"Next\",\"weight\":0},"
+		"{\"from\":1,\"to\":2,\"event\":\"Next\",\"weight\":1},"
+		"{\"from\":2,\"to\":0,\"event\":\"Reset\",\"weight\":0}]}\n");
+}
+
+TEST_CASE("Transition counters", "[fsm]")
+{
+	Context ctx;
+	fsm::profiled_fsm<table, Context> sm(ctx);
+
+	REQUIRE(sm.on(Next{}));
+	REQUIRE(sm.on(Next{}));
+	REQUIRE(sm.on(Reset{}));
+
+	ctx.allow = false;
+	REQUIRE_FALSE(sm.on(Next{}));
+
+	/* no transition at all is not counted */
+	REQUIRE_FALSE(sm.on(Reset{}));
+
+	ctx.allow = true;
+	REQUIRE(sm.on(Next{}));
+
+	const auto &stats = sm.stats();
+	REQUIRE(stats.transitions[0].hits == 2);
+	REQUIRE(stats.transitions[0].rejected == 1);
+	REQUIRE(stats.transitions[1].hits == 1);
+	REQUIRE(stats.transitions[2].hits == 1);
+	REQUIRE(stats.totalHits() == 4);
+	REQUIRE(stats.transitions[0].percentile(0.5) <= stats.transitions[0].percentile(0.99));
+
+	std::ostringstream json;
+	fsm::write_json(json, stats);
+	REQUIRE(json.str().find("\"hits\":2,\"rejected\":1") != std::string::npos);
+
+	std::ostringstream dot;
+	fsm::write_dot(dot, stats);
+	REQUIRE(dot.str().find("hits 2, rejected 1") != std::string::npos);
+
+	sm.resetStats();
+	REQUIRE(sm.stats().totalHits() == 0);
+}
+
+TEST_CASE("Latency percentiles", "[fsm]")
+{
+	fsm::transition_counter c;
+
+	for (int i = 0; i < 99; ++i) {
+		c.record(true, std::chrono::nanoseconds(100));
+	}
+
+	c.record(true, std::chrono::nanoseconds(5000));
+
+	/* 100ns falls in [64, 128) bucket, 5000ns in [4096, 8192) */
+	REQUIRE(c.percentile(0.5) == 127);
+	REQUIRE(c.percentile(0.99) == 127);
+	REQUIRE(c.percentile(1.0) == 8191);
+}
@@ -0,0 +1,47 @@
+#include <fsm.hpp>
+#include "catch.hpp"
+
+namespace extern_dispatch
+{
+
+struct Open {};
+struct Close {};
+struct Ignored {};
+
+template<std::size_t ID>
+struct S : public fsm::state<ID>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Open &) { return true; }
+	bool event(const Close &) { return true; }
+};
+
+using machine = fsm::fsm<fsm::transitions<
+	fsm::transition<S<1>, Open, S<2>>,
+	fsm::transition<S<2>, Close, S<1>>
+>>;
+
+}
+
+/* what a header would declare, instantiation is at the end of this file */
+FSM_EXTERN_DISPATCH(extern_dispatch::machine, extern_dispatch::Open, extern_dispatch::Close);
+
+TEST_CASE("Extern dispatch", "[fsm]")
+{
+	using namespace extern_dispatch;
+
+	machine m;
+
+	REQUIRE(m.on(Open{}));
+	REQUIRE(m.currentState() == 2);
+	REQUIRE_FALSE(m.on(Open{}));
+	REQUIRE(m.on(Close{}));
+	REQUIRE(m.currentState() == 1);
+
+	/* events not listed are still instantiated implicitly */
+	REQUIRE_FALSE(m.on(Ignored{}));
+}
+
+FSM_INSTANTIATE_DISPATCH(extern_dispatch::machine, extern_dispatch::Open, extern_dispatch::Close);
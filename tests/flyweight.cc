@@ -0,0 +1,82 @@
+#include <fsm.hpp>
+#include "catch.hpp"
+
+namespace
+{
+
+struct Connect {};
+struct Disconnect {};
+
+/* All the data lives in the context, each machine owns one */
+struct Context {
+	int connects = 0;
+	int disconnects = 0;
+};
+
+/* Flyweight states are empty, every hook receives the context */
+struct Idle : public fsm::state<1>
+{
+	void enter(Context &) {}
+	void exit(Context &) {}
+
+	bool event(Context &ctx, const Connect &)
+	{
+		ctx.connects ++;
+		return true;
+	}
+};
+
+struct Connected : public fsm::state<2>
+{
+	void enter(Context &) {}
+	void exit(Context &ctx) { ctx.disconnects ++; }
+
+	bool event(Context &, const Disconnect &) { return true; }
+};
+
+using transition_table = fsm::transitions<
+	fsm::transition<Idle, Connect, Connected>,
+	fsm::transition<Connected, Disconnect, Idle>
+>;
+
+using machine = fsm::fsm<transition_table, fsm::flyweight<Context>>;
+
+struct expected_layout {
+	Context ctx;
+	machine::index_t index;
+};
+
+}
+
+TEST_CASE("Flyweight states", "[fsm]")
+{
+	/* no per-machine state objects, just the context and the index */
+	static_assert(sizeof(machine) == sizeof(expected_layout), "flyweight machine too big");
+
+	machine a, b;
+
+	REQUIRE(a.currentState() == 1);
+	a.on(Connect{});
+	REQUIRE(a.currentState() == 2);
+	REQUIRE(a.context().connects == 1);
+
+	a.on(Disconnect{});
+	REQUIRE(a.currentState() == 1);
+	REQUIRE(a.context().disconnects == 1);
+
+	/* machines do not share their contexts */
+	REQUIRE(b.currentState() == 1);
+	REQUIRE(b.context().connects == 0);
+}
+
+TEST_CASE("Flyweight machine with initial context", "[fsm]")
+{
+	Context initial;
+	initial.connects = 10;
+
+	machine sm(initial);
+
+	sm.on(Connect{});
+	REQUIRE(sm.context().connects == 11);
+	REQUIRE(initial.connects == 10);
+}
@@ -0,0 +1,107 @@
+/* indices of generated tables are checked against their state order */
+#define FSM_CHECK_INDEXED
+
+#include <fsm.hpp>
+#include "catch.hpp"
+
+namespace gen
+{
+
+struct Next {};
+struct Jump {};
+
+template<std::size_t ID>
+struct Ring : public fsm::state<ID>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Next &) { return true; }
+	bool event(const Jump &) { return true; }
+};
+
+struct Connect {};
+struct Connected {};
+struct Close {};
+
+template<std::size_t ID>
+struct Conn : public fsm::state<ID>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Connect &) { return true; }
+	bool event(const Connected &) { return true; }
+	bool event(const Close &) { return true; }
+};
+
+using Idle = Conn<1>;
+using Connecting = Conn<2>;
+using Up = Conn<3>;
+
+}
+
+/* generated by fsm_generate_table() from generated.fsm and generated.dot */
+#include "ring_table.hpp"
+#include "connection_table.hpp"
+
+TEST_CASE("Table generated from text", "[fsm]")
+{
+	using namespace gen;
+
+	static_assert(ring_table::precomputed::value, "generated table has precomputed indices");
+	static_assert(std::is_same<
+		ring_table::states_tuple_t,
+		std::tuple<Ring<1>, Ring<2>, Ring<3>, Ring<4>, Ring<5>, Ring<6>>>::value,
+		"states keep order derived from transitions");
+
+	fsm::fsm<ring_table> sm;
+
+	for (std::size_t i = 0; i < 12; ++i) {
+		REQUIRE(sm.currentState() == i % 6 + 1);
+		REQUIRE(sm.on(Next{}));
+	}
+
+	REQUIRE_FALSE(sm.on(Jump{}));
+	sm.on(Next{});
+	sm.on(Next{});
+	REQUIRE(sm.currentState() == 3);
+	REQUIRE(sm.on(Jump{}));
+	REQUIRE(sm.currentState() == 1);
+}
+
+TEST_CASE("Table generated from DOT", "[fsm]")
+{
+	using namespace gen;
+
+	static_assert(connection_table::precomputed::value, "generated table has precomputed indices");
+	static_assert(std::is_same<fsm::meta::front<connection_table::unique_states>, Idle>::value,
+		"initial state gets index 0");
+
+	fsm::fsm<connection_table> sm;
+
+	REQUIRE(sm.currentState() == 1);
+	REQUIRE_FALSE(sm.on(Close{}));
+	REQUIRE(sm.on(Connect{}));
+	REQUIRE(sm.on(Close{}));
+	REQUIRE(sm.currentState() == 1);
+	REQUIRE(sm.on(Connect{}));
+	REQUIRE(sm.on(Connected{}));
+	REQUIRE(sm.currentState() == 3);
+	REQUIRE(sm.on(Close{}));
+	REQUIRE(sm.currentState() == 1);
+}
+
+TEST_CASE("Pruned generated table", "[fsm]")
+{
+	using namespace gen;
+
+	/* pruning drops precomputed indices */
+	using pruned = fsm::prune_unreachable<connection_table>;
+	static_assert(!pruned::precomputed::value, "indices don't hold after pruning");
+
+	fsm::fsm<pruned> sm;
+	REQUIRE(sm.on(Connect{}));
+	REQUIRE(sm.on(Connected{}));
+	REQUIRE(sm.currentState() == 3);
+}
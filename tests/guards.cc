@@ -0,0 +1,253 @@
+#include <fsm/export.hpp>
+#include "catch.hpp"
+
+#include <sstream>
+
+namespace
+{
+
+struct Coin {
+	static constexpr const char *name = "Coin";
+	int value;
+};
+
+struct Push { static constexpr const char *name = "Push"; };
+
+struct Context {
+	int credit = 0;
+	int price = 2;
+	int entered = 0;
+	int exited = 0;
+	bool accept = true;
+};
+
+template<std::size_t ID>
+struct Turnstile : public fsm::state<ID>
+{
+	Turnstile(Context &ctx) : ctx_(ctx) {}
+
+	void enter() { ++ctx_.entered; }
+	void exit() { ++ctx_.exited; }
+
+	bool event(const Coin &c) { ctx_.credit += c.value; return ctx_.accept; }
+	bool event(const Push &) { ctx_.credit = 0; return true; }
+
+	Context &ctx_;
+};
+
+using Locked = Turnstile<1>;
+using Unlocked = Turnstile<2>;
+using Alarm = Turnstile<3>;
+
+/* guards on the event only */
+struct Counterfeit {
+	static constexpr const char *name = "Counterfeit";
+	bool operator()(const Coin &c) const { return c.value <= 0; }
+};
+
+/* guards given the context of the machine */
+struct Enough {
+	static constexpr const char *name = "Enough";
+	bool operator()(Context &ctx, const Coin &c) const { return ctx.credit + c.value >= ctx.price; }
+};
+
+/* Coin in Locked: counterfeit raises the alarm, enough credit unlocks,
+ * anything else keeps it locked and only adds credit */
+using table = fsm::transitions<
+	fsm::transition<Locked, Coin, Alarm, Counterfeit>,
+	fsm::transition<Locked, Coin, Unlocked, Enough>,
+	fsm::transition<Locked, Coin, Locked>,
+	fsm::transition<Unlocked, Push, Locked>,
+	fsm::transition<Alarm, Push, Locked>
+>;
+
+using machine = fsm::fsm<table, Context>;
+
+/* no fallback, coins which pass neither guard are rejected */
+struct Large {
+	bool operator()(const Coin &c) const noexcept { return c.value >= 5; }
+};
+
+struct Small {
+	bool operator()(const Coin &c) const noexcept { return c.value == 1; }
+};
+
+template<std::size_t ID>
+struct Plain : public fsm::state<ID>
+{
+	void enter() noexcept {}
+	void exit() noexcept {}
+
+	template<typename E>
+	bool event(const E &) noexcept { return true; }
+};
+
+using plain_table = fsm::transitions<
+	fsm::transition<Plain<1>, Coin, Plain<2>, Large>,
+	fsm::transition<Plain<1>, Coin, Plain<3>, Small>,
+	fsm::transition<Plain<2>, Push, Plain<1>>,
+	fsm::transition<Plain<3>, Push, Plain<1>>
+>;
+
+using plain_machine = fsm::fsm<plain_table>;
+
+/* flyweight machines pass their own context */
+struct Shared {
+	int credit = 0;
+};
+
+struct HasCredit {
+	bool operator()(Shared &ctx, const Push &) const { return ctx.credit > 0; }
+};
+
+struct Idle : public fsm::state<1>
+{
+	void enter(Shared &) {}
+	void exit(Shared &) {}
+
+	bool event(Shared &ctx, const Coin &c) { ctx.credit += c.value; return true; }
+	bool event(Shared &, const Push &) { return true; }
+};
+
+struct Served : public fsm::state<2>
+{
+	void enter(Shared &ctx) { --ctx.credit; }
+	void exit(Shared &) {}
+
+	bool event(Shared &, const Push &) { return true; }
+};
+
+using flyweight_machine = fsm::fsm<fsm::transitions<
+	fsm::transition<Idle, Coin, Idle>,
+	fsm::transition<Idle, Push, Served, HasCredit>,
+	fsm::transition<Served, Push, Idle>
+>, fsm::flyweight<Shared>>;
+
+}
+
+TEST_CASE("Guarded alternatives are tried in order", "[fsm]")
+{
+	Context ctx;
+	machine m(ctx);
+
+	REQUIRE(ctx.entered == 1);
+
+	/* fallback, credit is added and Locked is entered again */
+	REQUIRE(m.on(Coin{1}));
+	REQUIRE(m.currentState() == 1);
+	REQUIRE(ctx.credit == 1);
+	REQUIRE(ctx.exited == 1);
+
+	/* Enough sees credit before event() of the state adds the coin */
+	REQUIRE(m.on(Coin{1}));
+	REQUIRE(m.currentState() == 2);
+	REQUIRE(ctx.credit == 2);
+
+	REQUIRE(m.on(Push{}));
+	REQUIRE(m.currentState() == 1);
+
+	/* the first passing guard wins even though Enough would pass too */
+	ctx.credit = 5;
+	REQUIRE(m.on(Coin{0}));
+	REQUIRE(m.currentState() == 3);
+
+	REQUIRE_FALSE(m.on(Coin{1}));
+	REQUIRE(m.on(Push{}));
+	REQUIRE(m.currentState() == 1);
+}
+
+TEST_CASE("Rejected alternative is not followed by the next one", "[fsm]")
+{
+	Context ctx;
+	machine m(ctx);
+
+	/* Enough passes, event() of Locked rejects, fallback is not tried */
+	ctx.accept = false;
+	REQUIRE_FALSE(m.on(Coin{3}));
+	REQUIRE(m.currentState() == 1);
+	REQUIRE(ctx.exited == 0);
+}
+
+TEST_CASE("Event passing no guard is rejected", "[fsm]")
+{
+	plain_machine m;
+
+	static_assert(plain_machine::nothrow_on<Coin>::value, "noexcept guards and hooks");
+	static_assert(!machine::nothrow_on<Coin>::value, "guards may throw");
+
+	REQUIRE_FALSE(m.on(Coin{2}));
+	REQUIRE(m.currentState() == 1);
+	REQUIRE(m.canHandle<Coin>());
+
+	REQUIRE(m.on(Coin{1}));
+	REQUIRE(m.currentState() == 3);
+	REQUIRE(m.on(Push{}));
+
+	REQUIRE(m.on(Coin{7}));
+	REQUIRE(m.currentState() == 2);
+
+	/* no context is kept when no guard needs it */
+	static_assert(sizeof(plain_machine) == sizeof(plain_machine::index_t), "empty states only");
+}
+
+TEST_CASE("Guards of flyweight machine get its context", "[fsm]")
+{
+	flyweight_machine m;
+
+	REQUIRE_FALSE(m.on(Push{}));
+	REQUIRE(m.currentState() == 1);
+
+	REQUIRE(m.on(Coin{1}));
+	REQUIRE(m.on(Push{}));
+	REQUIRE(m.currentState() == 2);
+	REQUIRE(m.context().credit == 0);
+}
+
+TEST_CASE("Guarded states are kept by minimize and shown by exporters", "[fsm]")
+{
+	static_assert(table::guarded::value, "table has guards");
+	static_assert(std::is_same<fsm::minimize<table>, table>::value, "nothing to merge");
+
+	std::ostringstream dot;
+	fsm::write_dot<table>(dot, "turnstile");
+	REQUIRE(dot.str().find("s0 -> s2 [label=\"Coin [Counterfeit]\"];") != std::string::npos);
+	REQUIRE(dot.str().find("s0 -> s1 [label=\"Coin [Enough]\"];") != std::string::npos);
+
+	std::ostringstream json;
+	fsm::write_json<table>(json);
+	REQUIRE(json.str().find("\"guard\":\"Enough\"") != std::string::npos);
+}
+
+TEST_CASE("Profiled machine counts guarded alternatives apart", "[fsm]")
+{
+	Context ctx;
+	fsm::profiled_fsm<table, Context> m(ctx);
+
+	/* credit only, kept locked by the unguarded fallback */
+	REQUIRE(m.on(Coin{1}));
+	REQUIRE(m.currentState() == 1);
+
+	/* enough credit unlocks */
+	REQUIRE(m.on(Coin{1}));
+	REQUIRE(m.currentState() == 2);
+	REQUIRE(m.on(Push{}));
+
+	/* counterfeit raises the alarm */
+	REQUIRE(m.on(Coin{0}));
+	REQUIRE(m.currentState() == 3);
+	REQUIRE(m.on(Push{}));
+
+	/* rejected by event() after Enough passed */
+	ctx.accept = false;
+	REQUIRE_FALSE(m.on(Coin{2}));
+
+	const auto &stats = m.stats();
+	REQUIRE(stats.transitions[0].hits == 1);
+	REQUIRE(stats.transitions[0].rejected == 0);
+	REQUIRE(stats.transitions[1].hits == 1);
+	REQUIRE(stats.transitions[1].rejected == 1);
+	REQUIRE(stats.transitions[2].hits == 1);
+	REQUIRE(stats.transitions[2].rejected == 0);
+	REQUIRE(stats.transitions[3].hits == 1);
+	REQUIRE(stats.transitions[4].hits == 1);
+}
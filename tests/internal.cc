@@ -0,0 +1,196 @@
+#include <fsm/export.hpp>
+#include <fsm/timer.hpp>
+#include "catch.hpp"
+
+#include <sstream>
+
+namespace
+{
+
+struct Tick {
+	static constexpr const char *name = "Tick";
+	int amount;
+};
+
+struct Reset { static constexpr const char *name = "Reset"; };
+struct Stop { static constexpr const char *name = "Stop"; };
+
+struct Context {
+	int counter = 0;
+	int entered = 0;
+	int exited = 0;
+};
+
+template<std::size_t ID>
+struct Counting : public fsm::state<ID>
+{
+	Counting(Context &ctx) : ctx_(ctx) {}
+
+	void enter() { ++ctx_.entered; }
+	void exit() { ++ctx_.exited; }
+
+	bool event(const Tick &t) { ctx_.counter += t.amount; return t.amount > 0; }
+	bool event(const Reset &) { ctx_.counter = 0; return true; }
+	bool event(const Stop &) { return true; }
+
+	Context &ctx_;
+};
+
+using Running = Counting<1>;
+using Stopped = Counting<2>;
+
+/* Tick only updates the counter, Reset starts Running over */
+using table = fsm::transitions<
+	fsm::internal<Running, Tick>,
+	fsm::transition<Running, Reset, Running>,
+	fsm::transition<Running, Stop, Stopped>,
+	fsm::transition<Stopped, Reset, Running>
+>;
+
+using machine = fsm::fsm<table, Context>;
+
+struct Overflow {
+	bool operator()(Context &ctx, const Tick &t) const { return ctx.counter + t.amount > 10; }
+};
+
+/* internal transition as fallback of a guarded one */
+using guarded_table = fsm::transitions<
+	fsm::transition<Running, Tick, Stopped, Overflow>,
+	fsm::internal<Running, Tick>,
+	fsm::transition<Stopped, Reset, Running>
+>;
+
+struct Poll {};
+struct Expired {};
+
+struct Ping {
+	bool restart;
+};
+
+struct Waiting : public fsm::state<1>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Poll &) { return true; }
+	bool event(const Expired &) { return true; }
+	bool event(const Ping &) { return true; }
+};
+
+struct Done : public fsm::state<2>
+{
+	void enter() {}
+	void exit() {}
+};
+
+using timed_table = fsm::transitions<
+	fsm::internal<Waiting, Poll>,
+	fsm::transition<Waiting, Expired, Done>,
+	fsm::timeout<Waiting, fsm::milliseconds<100>, Expired>
+>;
+
+struct Restart {
+	bool operator()(const Ping &p) const { return p.restart; }
+};
+
+/* Ping restarts Waiting or leaves it alone */
+using mixed_timed_table = fsm::transitions<
+	fsm::transition<Waiting, Ping, Waiting, Restart>,
+	fsm::internal<Waiting, Ping>,
+	fsm::transition<Waiting, Expired, Done>,
+	fsm::timeout<Waiting, fsm::milliseconds<100>, Expired>
+>;
+
+}
+
+TEST_CASE("Internal transition calls only event()", "[fsm]")
+{
+	Context ctx;
+	machine m(ctx);
+
+	REQUIRE(ctx.entered == 1);
+
+	REQUIRE(m.on(Tick{2}));
+	REQUIRE(m.on(Tick{3}));
+	REQUIRE(m.currentState() == 1);
+	REQUIRE(ctx.counter == 5);
+	REQUIRE(ctx.entered == 1);
+	REQUIRE(ctx.exited == 0);
+
+	/* rejected by event(), nothing else happens either */
+	REQUIRE_FALSE(m.on(Tick{0}));
+	REQUIRE(ctx.exited == 0);
+
+	/* external self-transition runs both hooks */
+	REQUIRE(m.on(Reset{}));
+	REQUIRE(m.currentState() == 1);
+	REQUIRE(ctx.counter == 0);
+	REQUIRE(ctx.exited == 1);
+	REQUIRE(ctx.entered == 2);
+
+	REQUIRE(m.on(Stop{}));
+	REQUIRE_FALSE(m.on(Tick{1}));
+	REQUIRE(m.currentState() == 2);
+}
+
+TEST_CASE("Internal transition as unguarded alternative", "[fsm]")
+{
+	Context ctx;
+	fsm::fsm<guarded_table, Context> m(ctx);
+
+	REQUIRE(m.on(Tick{6}));
+	REQUIRE(m.on(Tick{4}));
+	REQUIRE(m.currentState() == 1);
+	REQUIRE(ctx.exited == 0);
+
+	REQUIRE(m.on(Tick{1}));
+	REQUIRE(m.currentState() == 2);
+	REQUIRE(ctx.exited == 1);
+	REQUIRE(ctx.counter == 11);
+}
+
+TEST_CASE("Internal transition keeps timer running", "[fsm][timer]")
+{
+	fsm::timer_wheel wheel(std::chrono::milliseconds(1));
+	fsm::timed_fsm<timed_table> sm(wheel);
+
+	wheel.advance(std::chrono::milliseconds(60));
+	REQUIRE(sm.on(Poll{}));
+	REQUIRE(sm.timerArmed());
+
+	/* timeout is counted from entering Waiting, not from Poll */
+	REQUIRE(wheel.advance(std::chrono::milliseconds(40)) == 1);
+	REQUIRE(sm.currentState() == 2);
+}
+
+TEST_CASE("Timer follows the alternative taken", "[fsm][timer]")
+{
+	fsm::timer_wheel wheel(std::chrono::milliseconds(1));
+	fsm::timed_fsm<mixed_timed_table> sm(wheel);
+
+	/* external self-transition restarts the timer */
+	wheel.advance(std::chrono::milliseconds(60));
+	REQUIRE(sm.on(Ping{true}));
+	REQUIRE(wheel.advance(std::chrono::milliseconds(60)) == 0);
+	REQUIRE(sm.currentState() == 1);
+
+	/* internal one keeps it running */
+	REQUIRE(sm.on(Ping{false}));
+	REQUIRE(wheel.advance(std::chrono::milliseconds(40)) == 1);
+	REQUIRE(sm.currentState() == 2);
+}
+
+TEST_CASE("Internal transitions in minimized and exported tables", "[fsm]")
+{
+	static_assert(std::is_same<fsm::minimize<table>, table>::value, "nothing to merge");
+
+	std::ostringstream dot;
+	fsm::write_dot<table>(dot);
+	REQUIRE(dot.str().find("s0 -> s0 [label=\"Tick\", style=dashed];") != std::string::npos);
+	REQUIRE(dot.str().find("s0 -> s0 [label=\"Reset\"];") != std::string::npos);
+
+	std::ostringstream json;
+	fsm::write_json<table>(json);
+	REQUIRE(json.str().find("\"event\":\"Tick\",\"internal\":true") != std::string::npos);
+	REQUIRE(json.str().find("\"event\":\"Reset\",\"weight\"") != std::string::npos);
+}
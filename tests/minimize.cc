@@ -0,0 +1,83 @@
+#include <fsm.hpp>
+#include "catch.hpp"
+
+namespace
+{
+
+struct X {};
+struct Y {};
+struct Z {};
+
+template<std::size_t ID>
+struct Normal : public fsm::state<ID>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const X &) { return true; }
+	bool event(const Y &) { return true; }
+	bool event(const Z &) { return true; }
+};
+
+/* states only routing events, candidates for merging */
+template<std::size_t ID>
+struct Routing : public Normal<ID>
+{
+	using behavior_free = std::true_type;
+};
+
+/* R<3> and R<4> behave the same: Y leads both to N<5>. R<6> leads to
+ * different state, R<7> and R<8> are equivalent only because R<3> and
+ * R<4> are. N<9> is not behavior-free so it's never merged with N<5>. */
+using table = fsm::transitions<
+	fsm::transition<Normal<1>, X, Routing<3>>,
+	fsm::transition<Normal<1>, Z, Routing<4>>,
+	fsm::transition<Normal<1>, Y, Routing<6>>,
+	fsm::transition<Routing<3>, Y, Normal<5>>,
+	fsm::transition<Routing<4>, Y, Normal<5>>,
+	fsm::transition<Routing<6>, Y, Normal<9>>,
+	fsm::transition<Normal<5>, X, Routing<7>>,
+	fsm::transition<Normal<5>, Z, Routing<8>>,
+	fsm::transition<Routing<7>, X, Routing<3>>,
+	fsm::transition<Routing<8>, X, Routing<4>>,
+	fsm::transition<Normal<9>, X, Normal<1>>,
+	fsm::transition<Routing<7>, Y, Normal<1>>,
+	fsm::transition<Routing<8>, Y, Normal<1>>
+>;
+
+using minimal = fsm::minimize<table>;
+
+}
+
+TEST_CASE("Equivalent states are merged", "[fsm]")
+{
+	static_assert(table::states_count::value == 8, "unexpected number of states");
+	static_assert(minimal::states_count::value == 6, "R<4> and R<8> should be merged");
+	static_assert(std::is_same<
+		minimal::unique_states,
+		fsm::meta::list<Normal<1>, Routing<3>, Routing<6>, Normal<5>, Routing<7>, Normal<9>>>::value,
+		"unexpected states of minimal machine");
+
+	fsm::fsm<minimal> sm;
+
+	REQUIRE(sm.on(Z{}));
+	REQUIRE(sm.currentState() == 3);
+	REQUIRE(sm.on(Y{}));
+	REQUIRE(sm.currentState() == 5);
+	REQUIRE(sm.on(Z{}));
+	REQUIRE(sm.currentState() == 7);
+	REQUIRE(sm.on(X{}));
+	REQUIRE(sm.currentState() == 3);
+}
+
+TEST_CASE("Machine without behavior-free states is already minimal", "[fsm]")
+{
+	using plain = fsm::transitions<
+		fsm::transition<Normal<1>, X, Normal<2>>,
+		fsm::transition<Normal<3>, X, Normal<2>>,
+		fsm::transition<Normal<2>, X, Normal<3>>
+	>;
+
+	static_assert(std::is_same<fsm::minimize<plain>::list, plain::list>::value,
+		"nothing should be merged");
+}
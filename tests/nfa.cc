@@ -0,0 +1,155 @@
+#include <fsm/nfa.hpp>
+#include <fsm/dfa.hpp>
+#include "catch.hpp"
+
+#include <random>
+#include <string>
+
+namespace
+{
+
+using a = fsm::chars<'a'>;
+using b = fsm::chars<'b'>;
+using c = fsm::chars<'c'>;
+
+template<std::size_t ID>
+struct Q : public fsm::state<ID>
+{
+	void enter() {}
+	void exit() {}
+
+	template<typename E>
+	bool event(const E &) { return true; }
+};
+
+/* Q<N> is active when the N-th byte from the end is 'a', Q<0> keeps
+ * guessing. 'c' is handled only by Q<N>. */
+template<std::size_t N, std::size_t... Is>
+fsm::transitions<
+	fsm::transition<Q<0>, a, Q<0>>,
+	fsm::transition<Q<0>, b, Q<0>>,
+	fsm::transition<Q<0>, a, Q<1>>,
+	fsm::transition<Q<Is + 1>, a, Q<Is + 2>>...,
+	fsm::transition<Q<Is + 1>, b, Q<Is + 2>>...,
+	fsm::transition<Q<N>, c, Q<0>>
+> make_nth_from_end(fsm::meta::index_sequence<Is...>);
+
+template<std::size_t N>
+using nth_from_end = decltype(make_nth_from_end<N>(fsm::meta::make_index_sequence<N - 1>{}));
+
+using third = nth_from_end<3>;
+using third_dfa = fsm::determinize<third>;
+
+std::string random_input(std::mt19937 &gen, std::size_t n, bool withC)
+{
+	std::uniform_int_distribution<int> pick(0, withC ? 5 : 1);
+	std::string s;
+
+	for (std::size_t i = 0; i < n; ++i) {
+		const int k = pick(gen);
+		s += k == 0 ? 'b' : k == 5 ? 'c' : 'a';
+	}
+
+	return s;
+}
+
+/* subset of third_dfa with given ID contains S */
+template<typename S>
+bool in_third(std::size_t id)
+{
+	return fsm::subset_contains<third, S>(id);
+}
+
+template<typename M>
+bool send(M &m, char ch)
+{
+	return ch == 'a' ? m.on(a{}) : ch == 'b' ? m.on(b{}) : m.on(c{});
+}
+
+}
+
+TEST_CASE("Subset construction of nondeterministic table", "[fsm]")
+{
+	/* every subset of {Q<1>, Q<2>, Q<3>} together with Q<0> */
+	static_assert(third_dfa::states_count::value == 8, "unexpected number of subsets");
+	static_assert(std::is_same<
+		fsm::meta::front<third_dfa::unique_states>,
+		fsm::subset_state<0, Q<0>>>::value, "initial set holds the initial state only");
+	static_assert(fsm::meta::at_c<third_dfa::unique_states, 1>::contains<Q<1>>::value,
+		"'a' leads to Q<1>");
+
+	REQUIRE(in_third<Q<0>>(0));
+	REQUIRE_FALSE(in_third<Q<3>>(0));
+	REQUIRE_FALSE(in_third<Q<3>>(8));
+
+	fsm::fsm<third_dfa> m;
+
+	static_assert(fsm::fsm<third_dfa>::nothrow_on<a>::value, "subsets have noexcept hooks");
+
+	for (char ch : std::string("abb")) {
+		REQUIRE(send(m, ch));
+	}
+
+	REQUIRE(in_third<Q<3>>(m.currentState()));
+
+	REQUIRE(send(m, 'b'));
+	REQUIRE_FALSE(in_third<Q<3>>(m.currentState()));
+
+	/* nothing active handles 'c' */
+	const std::size_t before = m.currentState();
+	REQUIRE_FALSE(send(m, 'c'));
+	REQUIRE(m.currentState() == before);
+}
+
+TEST_CASE("Simulation and determinized table agree", "[fsm]")
+{
+	std::mt19937 gen(5);
+
+	for (std::size_t k = 0; k < 500; ++k) {
+		const std::string input = random_input(gen, 40, k % 2);
+
+		fsm::nfa<third> sim;
+		fsm::fsm<third_dfa> m;
+		fsm::dfa<third_dfa> bytes;
+
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			const bool handled = send(sim, input[i]);
+
+			REQUIRE(send(m, input[i]) == handled);
+			REQUIRE(bytes.feed(&input[i], 1) == (handled ? 1u : 0u));
+			REQUIRE(bytes.currentState() == m.currentState());
+
+			REQUIRE(sim.isActive<Q<0>>() == in_third<Q<0>>(m.currentState()));
+			REQUIRE(sim.isActive<Q<1>>() == in_third<Q<1>>(m.currentState()));
+			REQUIRE(sim.isActive<Q<2>>() == in_third<Q<2>>(m.currentState()));
+			REQUIRE(sim.isActive<Q<3>>() == in_third<Q<3>>(m.currentState()));
+		}
+	}
+}
+
+TEST_CASE("Simulation of table with more than 64 states", "[fsm]")
+{
+	/* determinized form would have 2^70 states */
+	using table = nth_from_end<70>;
+
+	std::mt19937 gen(9);
+	fsm::nfa<table> sim;
+
+	const std::string input = random_input(gen, 300, false);
+
+	for (std::size_t i = 0; i < input.size(); ++i) {
+		REQUIRE(send(sim, input[i]));
+
+		REQUIRE(sim.isActive<Q<0>>());
+		REQUIRE(sim.isActive<Q<1>>() == (input[i] == 'a'));
+		REQUIRE(sim.isActive<Q<70>>() == (i >= 69 && input[i - 69] == 'a'));
+	}
+
+	struct Unknown {};
+	REQUIRE_FALSE(sim.on(Unknown{}));
+
+	sim.reset();
+	REQUIRE(sim.isActiveIndex(0));
+	REQUIRE_FALSE(sim.isActive<Q<1>>());
+	REQUIRE_FALSE(sim.isActiveIndex(71));
+}
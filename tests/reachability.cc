@@ -0,0 +1,58 @@
+#include <fsm.hpp>
+#include "catch.hpp"
+
+namespace
+{
+
+struct Go {};
+struct Back {};
+
+template<std::size_t ID>
+struct S : public fsm::state<ID>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Go &) { return true; }
+	bool event(const Back &) { return true; }
+};
+
+/* S<4> and S<5> can't be reached from S<1> */
+using table = fsm::transitions<
+	fsm::transition<S<1>, Go, S<2>>,
+	fsm::transition<S<2>, Go, S<3>>,
+	fsm::transition<S<3>, Back, S<1>>,
+	fsm::transition<S<4>, Go, S<5>>,
+	fsm::transition<S<5>, Back, S<2>>,
+	fsm::timeout<S<4>, fsm::seconds<1>, Back>
+>;
+
+using pruned = fsm::prune_unreachable<table>;
+
+}
+
+TEST_CASE("Unreachable states are detected", "[fsm]")
+{
+	static_assert(!table::all_reachable::value, "S<4> and S<5> are unreachable");
+	static_assert(std::is_same<table::unreachable_states, fsm::meta::list<S<4>, S<5>>>::value,
+		"unexpected unreachable states");
+	static_assert(std::is_same<table::reachable_states, fsm::meta::list<S<1>, S<2>, S<3>>>::value,
+		"unexpected reachable states");
+}
+
+TEST_CASE("Unreachable states are pruned", "[fsm]")
+{
+	static_assert(pruned::all_reachable::value, "pruned table has unreachable states");
+	static_assert(pruned::states_count::value == 3, "pruned table should have three states");
+	static_assert(pruned::list::size() == 3, "pruned table should have three transitions");
+	static_assert(pruned::timeouts::size() == 0, "timeout of unreachable state should be dropped");
+
+	fsm::fsm<pruned> sm;
+
+	REQUIRE(sm.currentState() == 1);
+	sm.on(Go{});
+	sm.on(Go{});
+	REQUIRE(sm.currentState() == 3);
+	sm.on(Back{});
+	REQUIRE(sm.currentState() == 1);
+}
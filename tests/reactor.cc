@@ -0,0 +1,145 @@
+#include <fsm/reactor.hpp>
+#include "catch.hpp"
+#include <memory>
+#include <sys/socket.h>
+
+namespace
+{
+
+/* readiness events, DataReady carries the descriptor */
+struct DataReady {
+	explicit DataReady(int fd) : fd (fd) {}
+	int fd;
+};
+
+struct PeerClosed {};
+
+struct Context {
+	std::size_t received = 0;
+};
+
+struct Waiting : public fsm::state<1>
+{
+	Waiting(Context &ctx) : ctx_(ctx) {}
+
+	void enter() {}
+	void exit() {}
+
+	bool event(const DataReady &e)
+	{
+		char buf[64];
+		ssize_t n = ::read(e.fd, buf, sizeof(buf));
+
+		if (n > 0) {
+			ctx_.received += n;
+		}
+
+		return n > 0;
+	}
+
+	bool event(const PeerClosed &) { return true; }
+
+	Context &ctx_;
+};
+
+struct Closed : public fsm::state<2>
+{
+	Closed(Context &) {}
+
+	void enter() {}
+	void exit() {}
+};
+
+using transition_table = fsm::transitions<
+	fsm::transition<Waiting, DataReady, Waiting>,
+	fsm::transition<Waiting, PeerClosed, Closed>
+>;
+
+using machine = fsm::fsm<transition_table, Context>;
+using watch = fsm::fd_watch<machine, DataReady, void, PeerClosed>;
+
+/* connected descriptors closed when the test leaves, also on failure,
+ * closing them drops their epoll registrations as well */
+struct fd_pair
+{
+	~fd_pair()
+	{
+		close(0);
+		close(1);
+	}
+
+	void close(int i)
+	{
+		if (fd[i] >= 0) {
+			::close(fd[i]);
+			fd[i] = -1;
+		}
+	}
+
+	int fd[2] = {-1, -1};
+};
+
+}
+
+TEST_CASE("Reactor dispatches readiness of pipes in one batch", "[fsm][reactor]")
+{
+	fsm::reactor r;
+	REQUIRE(r.valid());
+
+	const int count = 3;
+	fd_pair pipes[count];
+	Context ctx[count];
+	std::unique_ptr<machine> machines[count];
+	std::unique_ptr<watch> watches[count];
+
+	for (int i = 0; i < count; ++i) {
+		REQUIRE(::pipe(pipes[i].fd) == 0);
+		machines[i].reset(new machine(ctx[i]));
+		watches[i].reset(new watch(*machines[i], pipes[i].fd[0]));
+		REQUIRE(r.add(*watches[i]));
+	}
+
+	/* nothing ready yet */
+	REQUIRE(r.poll(0) == 0);
+
+	for (int i = 0; i < count; ++i) {
+		REQUIRE(::write(pipes[i].fd[1], "hello", i + 1) == i + 1);
+	}
+
+	/* all three pipes reported by a single wait */
+	REQUIRE(r.poll(0) == count);
+
+	for (int i = 0; i < count; ++i) {
+		REQUIRE(ctx[i].received == static_cast<std::size_t>(i + 1));
+		REQUIRE(machines[i]->currentState() == 1);
+	}
+
+	REQUIRE(r.poll(0) == 0);
+
+	for (int i = 0; i < count; ++i) {
+		REQUIRE(r.remove(*watches[i]));
+	}
+}
+
+TEST_CASE("Reactor reports hang up of socket peer", "[fsm][reactor]")
+{
+	fsm::reactor r;
+
+	fd_pair sv;
+	REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv.fd) == 0);
+
+	Context ctx;
+	machine sm(ctx);
+	watch w(sm, sv.fd[0]);
+	REQUIRE(r.add(w));
+
+	REQUIRE(::write(sv.fd[1], "bye", 3) == 3);
+	sv.close(1);
+
+	/* data is delivered before the hang up */
+	REQUIRE(r.poll(0) == 1);
+	REQUIRE(ctx.received == 3);
+	REQUIRE(sm.currentState() == 2);
+
+	REQUIRE(r.remove(w));
+}
@@ -0,0 +1,119 @@
+#include <fsm/replay.hpp>
+#include "catch.hpp"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+
+struct Next {};
+struct Back {};
+struct Jump {};
+struct Reset {};
+struct Unknown {};
+
+template<std::size_t ID>
+struct S : public fsm::state<ID>
+{
+	using behavior_free = std::true_type;
+
+	void enter() {}
+	void exit() {}
+
+	template<typename E>
+	bool event(const E &) { return true; }
+};
+
+/* Reset is handled by some states only, the others ignore it */
+template<std::size_t N, std::size_t... Is>
+fsm::transitions<
+	fsm::transition<S<Is>, Next, S<(Is + 1) % N>>...,
+	fsm::transition<S<Is>, Back, S<(Is + N - 1) % N>>...,
+	fsm::transition<S<Is * 7 % N>, Jump, S<Is * 5 % N>>...,
+	fsm::transition<S<Is + 1>, Reset, S<0>>...
+> make_ring(fsm::meta::index_sequence<Is...>);
+
+template<std::size_t N>
+using ring = decltype(make_ring<N>(fsm::meta::make_index_sequence<N - 1>{}));
+
+template<typename Trs>
+std::vector<typename fsm::replay<Trs>::code_t> random_log(std::size_t n)
+{
+	using replay = fsm::replay<Trs>;
+
+	const typename replay::code_t codes[] = {
+		replay::template code<Next>(),
+		replay::template code<Back>(),
+		replay::template code<Jump>(),
+		replay::template code<Next>(),
+		replay::template code<Reset>(),
+		replay::template code<Unknown>(),
+	};
+
+	std::mt19937 gen(7);
+	std::uniform_int_distribution<std::size_t> pick(0, 5);
+	std::vector<typename replay::code_t> log(n);
+
+	for (auto &c : log) {
+		c = codes[pick(gen)];
+	}
+
+	return log;
+}
+
+template<typename Trs>
+void check_replay(std::size_t n)
+{
+	using replay = fsm::replay<Trs>;
+
+	auto log = random_log<Trs>(n);
+
+	/* expected states from the machine itself */
+	fsm::fsm<Trs> m;
+	std::vector<typename replay::index_t> expected(n);
+
+	for (std::size_t i = 0; i < n; ++i) {
+		if (log[i] == replay::template code<Next>()) {
+			m.on(Next{});
+		} else if (log[i] == replay::template code<Back>()) {
+			m.on(Back{});
+		} else if (log[i] == replay::template code<Jump>()) {
+			m.on(Jump{});
+		} else if (log[i] == replay::template code<Reset>()) {
+			m.on(Reset{});
+		} else {
+			m.on(Unknown{});
+		}
+
+		expected[i] = m.currentIndex();
+	}
+
+	for (unsigned threads : {1u, 2u, 3u, 8u}) {
+		REQUIRE(replay::finalState(log.data(), n, 0, threads) == m.currentIndex());
+
+		std::vector<typename replay::index_t> states(n);
+		REQUIRE(replay::trace(log.data(), n, states.data(), 0, threads) == m.currentIndex());
+		REQUIRE(states == expected);
+	}
+}
+
+}
+
+TEST_CASE("Replay matches the machine", "[fsm]")
+{
+	/* up to 16 states fit a single shuffle */
+	check_replay<ring<12>>(200000);
+	check_replay<ring<12>>(1000);
+	check_replay<ring<40>>(200000);
+}
+
+TEST_CASE("Replay of empty log and from other state", "[fsm]")
+{
+	using replay = fsm::replay<ring<12>>;
+
+	REQUIRE(replay::finalState(nullptr, 0, 5) == 5);
+
+	const replay::code_t log[] = {replay::code<Next>(), replay::code<Next>(), replay::code<Unknown>()};
+	REQUIRE(replay::finalState(log, 3, 5) == replay::next(replay::next(5, log[0]), log[1]));
+}
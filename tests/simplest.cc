@@ -1,3 +1,6 @@
+/* size of machines with empty states is checked by fsm.hpp */
+#define FSM_CHECK_EMPTY_STATES
+
 #include "catch.hpp"
 #include <fsm.hpp>
 
@@ -18,7 +21,9 @@ struct StateA : public fsm::state<1>
 	/* If there is transition from this state triggered by
 	 * some particular event you need to create event() method
 	 * with argument of Event type. Otherwise you will get
-	 * compile time error. */
+	 * compile time error. States without behavior of their
+	 * own can derive from fsm::empty_state, its hooks do
+	 * nothing and accept every event. */
 	bool event(const EventStep &)
 	{
 		/* return true to allow transition, false otherwise */
@@ -81,3 +86,43 @@ TEST_CASE("Two-way transition", "[fsm]")
 	sm.on(EventStep{});;
 	REQUIRE(sm.currentState() == 1);
 }
+
+TEST_CASE("State index type", "[fsm]")
+{
+	using transition_table = fsm::transitions<
+		fsm::transition<StateA, EventStep, StateB>
+	>;
+
+	using machine = fsm::fsm<transition_table>;
+
+	/* two states fit in a single byte index */
+	static_assert(std::is_same<machine::index_t, std::uint8_t>::value, "unexpected index type");
+	static_assert(std::is_same<fsm::detail::index_type<255>, std::uint8_t>::value, "unexpected index type");
+	static_assert(std::is_same<fsm::detail::index_type<256>, std::uint16_t>::value, "unexpected index type");
+	static_assert(std::is_same<fsm::detail::index_type<65536>, std::uint32_t>::value, "unexpected index type");
+
+	machine sm;
+
+	REQUIRE(sm.currentIndex() == 0);
+	sm.on(EventStep {});
+	REQUIRE(sm.currentIndex() == 1);
+}
+
+TEST_CASE("Empty states take no space", "[fsm]")
+{
+	using transition_table = fsm::transitions<
+		fsm::transition<StateA, EventStep, StateB>,
+		fsm::transition<StateB, EventStep, StateA>
+	>;
+
+	using machine = fsm::fsm<transition_table>;
+
+	/* StateA and StateB are empty, the whole machine is just its index */
+	static_assert(sizeof(machine) == sizeof(machine::index_t), "empty states should take no space");
+
+	machine sm;
+
+	REQUIRE(sm.currentState() == 1);
+	sm.on(EventStep{});
+	REQUIRE(sm.currentState() == 2);
+}
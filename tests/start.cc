@@ -0,0 +1,74 @@
+#include <fsm.hpp>
+#include "catch.hpp"
+
+namespace
+{
+
+struct Step {};
+
+struct Context {
+	int entered = 0;
+};
+
+template<std::size_t ID>
+struct S : public fsm::state<ID>
+{
+	S(Context &ctx) : ctx_(ctx) {}
+
+	void enter() { ctx_.entered = ID; }
+	void exit() {}
+
+	bool event(const Step &) { return true; }
+
+	Context &ctx_;
+};
+
+/* without initial<> S<1> would be the initial state */
+using table = fsm::transitions<
+	fsm::transition<S<1>, Step, S<2>>,
+	fsm::transition<S<2>, Step, S<3>>,
+	fsm::transition<S<3>, Step, S<1>>,
+	fsm::initial<S<3>>
+>;
+
+}
+
+TEST_CASE("Explicit initial state", "[fsm]")
+{
+	static_assert(std::is_same<fsm::meta::front<table::unique_states>, S<3>>::value,
+		"initial state should get index 0");
+	static_assert(table::list::size() == 3, "initial<> is not a transition");
+
+	Context ctx;
+	fsm::fsm<table, Context> sm(ctx);
+
+	/* constructor with context enters initial state as well */
+	REQUIRE(sm.started());
+	REQUIRE(sm.currentState() == 3);
+	REQUIRE(ctx.entered == 3);
+
+	sm.on(Step{});
+	REQUIRE(sm.currentState() == 1);
+}
+
+TEST_CASE("Lazy start", "[fsm]")
+{
+	Context ctx;
+	fsm::fsm<table, Context> sm(ctx, fsm::lazy_start);
+
+	REQUIRE_FALSE(sm.started());
+	REQUIRE(sm.currentState() == 0);
+	REQUIRE(ctx.entered == 0);
+
+	/* events are ignored until the machine is started */
+	REQUIRE_FALSE(sm.on(Step{}));
+
+	REQUIRE(sm.start());
+	REQUIRE(sm.started());
+	REQUIRE(sm.currentState() == 3);
+	REQUIRE(ctx.entered == 3);
+
+	REQUIRE_FALSE(sm.start());
+	REQUIRE(sm.on(Step{}));
+	REQUIRE(sm.currentState() == 1);
+}
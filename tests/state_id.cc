@@ -0,0 +1,126 @@
+#include <fsm.hpp>
+#include "catch.hpp"
+
+namespace
+{
+
+struct Next {};
+
+struct Context {
+	int entered = 0;
+};
+
+template<std::size_t ID>
+struct S : public fsm::state<ID>
+{
+	S(Context &ctx) : ctx_(ctx) {}
+
+	void enter() { ++ctx_.entered; }
+	void exit() {}
+
+	bool event(const Next &) { return true; }
+
+	Context &ctx_;
+};
+
+using dense_table = fsm::transitions<
+	fsm::transition<S<1>, Next, S<2>>,
+	fsm::transition<S<2>, Next, S<3>>,
+	fsm::transition<S<3>, Next, S<1>>
+>;
+
+/* IDs as they could come from a wire protocol */
+using sparse_table = fsm::transitions<
+	fsm::transition<S<100>, Next, S<2000>>,
+	fsm::transition<S<2000>, Next, S<35>>,
+	fsm::transition<S<35>, Next, S<7>>,
+	fsm::transition<S<7>, Next, S<100>>
+>;
+
+template<typename Trs>
+using id_map = fsm::detail::state_id_map<typename Trs::states_tuple_t, std::uint8_t>;
+
+}
+
+TEST_CASE("Dense state IDs", "[fsm]")
+{
+	using machine = fsm::fsm<dense_table, Context>;
+
+	/* IDs 1..3 of 3 states fit a table of 3 slots */
+	static_assert(id_map<dense_table>::modulus == 3, "dense IDs need no extra slots");
+
+	REQUIRE(machine::indexOf(1) == 0);
+	REQUIRE(machine::indexOf(2) == 1);
+	REQUIRE(machine::indexOf(3) == 2);
+	REQUIRE(machine::indexOf(0) == 3);
+	REQUIRE(machine::indexOf(4) == 3);
+	REQUIRE(machine::indexOf(1000) == 3);
+}
+
+TEST_CASE("Sparse state IDs", "[fsm]")
+{
+	using machine = fsm::fsm<sparse_table, Context>;
+
+	static_assert(id_map<sparse_table>::modulus < 2000, "sparse IDs are hashed");
+
+	REQUIRE(machine::indexOf(100) == 0);
+	REQUIRE(machine::indexOf(2000) == 1);
+	REQUIRE(machine::indexOf(35) == 2);
+	REQUIRE(machine::indexOf(7) == 3);
+
+	for (std::size_t id = 0; id < 3000; ++id) {
+		if (id != 100 && id != 2000 && id != 35 && id != 7) {
+			REQUIRE(machine::indexOf(id) == 4);
+		}
+	}
+}
+
+TEST_CASE("Restore state by ID", "[fsm]")
+{
+	Context ctx;
+	fsm::fsm<sparse_table, Context> sm(ctx);
+	REQUIRE(ctx.entered == 1);
+
+	/* hooks are not called on restore */
+	REQUIRE(sm.setStateById(35));
+	REQUIRE(sm.currentState() == 35);
+	REQUIRE(ctx.entered == 1);
+
+	REQUIRE_FALSE(sm.setStateById(36));
+	REQUIRE(sm.currentState() == 35);
+
+	REQUIRE(sm.on(Next{}));
+	REQUIRE(sm.currentState() == 7);
+
+	/* machine not started yet is started by restoring its state */
+	fsm::fsm<sparse_table, Context> lazy(ctx, fsm::lazy_start);
+	REQUIRE(lazy.setStateById(2000));
+	REQUIRE(lazy.started());
+	REQUIRE(lazy.on(Next{}));
+	REQUIRE(lazy.currentState() == 35);
+}
+
+namespace
+{
+
+/* empty states with the same ID share their empty base */
+struct Twin1 : public fsm::empty_state<0> {};
+struct Twin2 : public fsm::empty_state<0> {};
+
+}
+
+TEST_CASE("Empty states sharing a base", "[fsm]")
+{
+	using machine = fsm::fsm<fsm::transitions<
+		fsm::transition<Twin1, Next, Twin2>,
+		fsm::transition<Twin2, Next, Twin1>
+	>>;
+
+	/* bases of the same type can't share an address, the machine grows
+	 * but still works, FSM_CHECK_EMPTY_STATES would reject it */
+	machine sm;
+
+	REQUIRE(sm.currentIndex() == 0);
+	REQUIRE(sm.on(Next{}));
+	REQUIRE(sm.currentIndex() == 1);
+}
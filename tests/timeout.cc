@@ -0,0 +1,160 @@
+#include <fsm/timer.hpp>
+#include "catch.hpp"
+#include <vector>
+
+namespace
+{
+
+struct Activity {};
+struct IdleTimeout {};
+struct Hang {};
+struct HangTimeout {};
+
+struct Idle : public fsm::state<1>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Activity &) { return true; }
+	bool event(const IdleTimeout &) { return true; }
+};
+
+struct Active : public fsm::state<2>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const Activity &) { return true; }
+	bool event(const Hang &) { return true; }
+	bool event(const IdleTimeout &) { return true; }
+};
+
+struct Hung : public fsm::state<3>
+{
+	void enter() {}
+	void exit() {}
+
+	bool event(const HangTimeout &) { return true; }
+};
+
+struct Closed : public fsm::state<4>
+{
+	void enter() {}
+	void exit() {}
+};
+
+using transition_table = fsm::transitions<
+	fsm::transition<Idle, Activity, Active>,
+	fsm::transition<Idle, IdleTimeout, Closed>,
+	fsm::transition<Active, Activity, Active>,
+	fsm::transition<Active, Hang, Hung>,
+	fsm::transition<Active, IdleTimeout, Idle>,
+	fsm::transition<Hung, HangTimeout, Closed>,
+
+	fsm::timeout<Idle, fsm::milliseconds<100>, IdleTimeout>,
+	fsm::timeout<Active, fsm::seconds<1>, IdleTimeout>,
+	fsm::timeout<Hung, fsm::seconds<300>, HangTimeout>
+>;
+
+using ms = std::chrono::milliseconds;
+
+/* plain timer used to check the wheel itself */
+struct counting_timer : public fsm::timer_node
+{
+	counting_timer()
+	{
+		fire = [](fsm::timer_node &n) { static_cast<counting_timer &>(n).fired ++; };
+	}
+
+	int fired = 0;
+};
+
+}
+
+TEST_CASE("State timeout fires", "[fsm][timer]")
+{
+	fsm::timer_wheel wheel(ms(1));
+	fsm::timed_fsm<transition_table> sm(wheel);
+
+	REQUIRE(sm.timerArmed());
+	REQUIRE(wheel.advance(ms(99)) == 0);
+	REQUIRE(sm.currentState() == 1);
+
+	REQUIRE(wheel.advance(ms(1)) == 1);
+	REQUIRE(sm.currentState() == 4);
+	REQUIRE_FALSE(sm.timerArmed());
+	REQUIRE(wheel.size() == 0);
+}
+
+TEST_CASE("Leaving state cancels its timeout", "[fsm][timer]")
+{
+	fsm::timer_wheel wheel(ms(1));
+	fsm::timed_fsm<transition_table> sm(wheel);
+
+	wheel.advance(ms(50));
+	REQUIRE(sm.on(Activity{}));
+	REQUIRE(sm.currentState() == 2);
+
+	/* Active times out after 1s, activity restarts the timer */
+	wheel.advance(ms(900));
+	REQUIRE(sm.on(Activity{}));
+	wheel.advance(ms(900));
+	REQUIRE(sm.currentState() == 2);
+
+	/* Active times out back to Idle, which arms its own timer */
+	REQUIRE(wheel.advance(ms(100)) == 1);
+	REQUIRE(sm.currentState() == 1);
+	REQUIRE(sm.timerArmed());
+
+	REQUIRE(wheel.advance(ms(100)) == 1);
+	REQUIRE(sm.currentState() == 4);
+}
+
+TEST_CASE("Long timeout cascades through wheel levels", "[fsm][timer]")
+{
+	fsm::timer_wheel wheel(ms(1));
+	fsm::timed_fsm<transition_table> sm(wheel);
+
+	sm.on(Activity{});
+	sm.on(Hang{});
+	REQUIRE(sm.currentState() == 3);
+
+	wheel.advance(ms(299999));
+	REQUIRE(sm.currentState() == 3);
+	wheel.advance(ms(1));
+	REQUIRE(sm.currentState() == 4);
+}
+
+TEST_CASE("Timer wheel fires at exact tick", "[fsm][timer]")
+{
+	const std::vector<std::uint64_t> delays = {
+		1, 2, 255, 256, 257, 511, 65535, 65536, 65537, 70000, (1u << 24) + 5
+	};
+
+	fsm::timer_wheel wheel;
+	std::vector<counting_timer> timers(delays.size());
+
+	for (std::size_t i = 0; i < delays.size(); ++i) {
+		wheel.arm(timers[i], delays[i]);
+	}
+
+	/* cancelled timer never fires */
+	counting_timer cancelled;
+	wheel.arm(cancelled, 300);
+	wheel.cancel(cancelled);
+
+	REQUIRE(wheel.size() == delays.size());
+
+	for (std::uint64_t t = 1; t <= delays.back(); ++t) {
+		wheel.tick();
+
+		for (std::size_t i = 0; i < delays.size(); ++i) {
+			if (timers[i].fired != (t >= delays[i] ? 1 : 0)) {
+				FAIL("timer " << i << " fired " << timers[i].fired << " times at tick " << t);
+			}
+		}
+	}
+
+	REQUIRE(wheel.size() == 0);
+	REQUIRE(cancelled.fired == 0);
+}
@@ -0,0 +1,139 @@
+#include <fsm.hpp>
+#include <fsm/export.hpp>
+#include "catch.hpp"
+
+#include <variant>
+
+namespace
+{
+
+struct Open {};
+struct Close {};
+struct Lock {};
+struct Unknown {};
+
+struct Context {
+	int entered = 0;
+	int exited = 0;
+};
+
+template<std::size_t ID>
+struct Door : public fsm::state<ID>
+{
+	Door(Context &ctx) : ctx_(ctx) {}
+
+	void enter() { ++ctx_.entered; }
+	void exit() { ++ctx_.exited; }
+
+	bool event(const Open &) { return true; }
+	bool event(const Close &) { return true; }
+	bool event(const Lock &) { return ID != 3; }
+
+	Context &ctx_;
+};
+
+using table = fsm::transitions<
+	fsm::transition<Door<1>, Open, Door<2>>,
+	fsm::transition<Door<2>, Close, Door<1>>,
+	fsm::transition<Door<1>, Lock, Door<3>>,
+	fsm::transition<Door<3>, Open, Door<1>>
+>;
+
+using machine = fsm::fsm<table, Context>;
+using event = std::variant<Open, Close, Lock, Unknown>;
+
+/* throws when moved, used to make a variant valueless */
+struct Broken {
+	Broken() = default;
+	Broken(Broken &&) { throw 1; }
+};
+
+}
+
+TEST_CASE("Variant events are dispatched by state and alternative", "[fsm]")
+{
+	Context ctx;
+	machine m(ctx);
+
+	REQUIRE(m.currentState() == 1);
+
+	REQUIRE(m.on(event{Open{}}));
+	REQUIRE(m.currentState() == 2);
+
+	/* no transition from 2 on Lock */
+	REQUIRE_FALSE(m.on(event{Lock{}}));
+	REQUIRE(m.currentState() == 2);
+
+	REQUIRE(m.on(event{Close{}}));
+	REQUIRE(m.on(event{Lock{}}));
+	REQUIRE(m.currentState() == 3);
+
+	/* alternatives not in the table are rejected in any state */
+	REQUIRE_FALSE(m.on(event{Unknown{}}));
+
+	REQUIRE(m.on(event{Open{}}));
+	REQUIRE(m.currentState() == 1);
+	REQUIRE(ctx.entered == 5);
+	REQUIRE(ctx.exited == 4);
+}
+
+TEST_CASE("Variant dispatch matches on(E)", "[fsm]")
+{
+	Context a, b;
+	machine byVariant(a);
+	machine byType(b);
+
+	const event events[] = {Lock{}, Close{}, Open{}, Unknown{}, Open{}, Lock{}, Close{}};
+
+	for (const event &e : events) {
+		const bool expected = std::visit([&](const auto &x) { return byType.on(x); }, e);
+
+		REQUIRE(byVariant.on(e) == expected);
+		REQUIRE(byVariant.currentState() == byType.currentState());
+	}
+}
+
+TEST_CASE("Variant events before start and valueless variants", "[fsm]")
+{
+	Context ctx;
+	machine m(ctx, fsm::lazy_start);
+
+	REQUIRE_FALSE(m.on(event{Open{}}));
+	REQUIRE(m.start());
+
+	std::variant<Open, Broken> broken;
+
+	try {
+		broken.emplace<1>(Broken{});
+	} catch (int) {
+	}
+
+	REQUIRE(broken.valueless_by_exception());
+	REQUIRE_FALSE(m.on(broken));
+	REQUIRE(m.currentState() == 1);
+
+	/* noexcept follows hooks of all alternatives */
+	static_assert(!noexcept(m.on(event{})), "hooks may throw");
+}
+
+TEST_CASE("Profiled machine counts variant events", "[fsm]")
+{
+	Context ctx;
+	fsm::profiled_fsm<table, Context> m(ctx);
+
+	REQUIRE(m.on(event{Open{}}));
+	REQUIRE(m.on(event{Close{}}));
+	REQUIRE(m.on(event{Lock{}}));
+	REQUIRE(m.on(event{Open{}}));
+
+	/* no transition for these, nothing is counted */
+	REQUIRE_FALSE(m.on(event{Unknown{}}));
+	REQUIRE_FALSE(m.on(event{Close{}}));
+
+	const auto &stats = m.stats();
+	REQUIRE(stats.transitions[0].hits == 1);
+	REQUIRE(stats.transitions[1].hits == 1);
+	REQUIRE(stats.transitions[2].hits == 1);
+	REQUIRE(stats.transitions[3].hits == 1);
+	REQUIRE(stats.totalHits() == 4);
+}
@@ -0,0 +1,513 @@
+// fsm-gen: emits header with fsm::transitions table from compact textual
+// or DOT description. State indices are computed here so the compiler
+// doesn't have to derive them for large tables.
+//
+// usage: fsm-gen [--namespace NS] [--include HEADER]... NAME INPUT OUTPUT
+//
+// Textual description (any file not ending with .dot or .gv), one entry
+// per line, # starts a comment:
+//
+//	initial Idle
+//	Idle Connect Connecting
+//	Connecting Connected Up 100
+//
+// a transition is StartState Event StopState with optional weight making
+// it fsm::hot. DOT description is a digraph with event as edge label:
+//
+//	digraph conn {
+//		Idle [initial=true];
+//		Idle -> Connecting [label=Connect];
+//		Connecting -> Up [label=Connected, weight=100];
+//	}
+//
+// Without initial state the start state of the first transition is used.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct transition
+{
+	std::string start;
+	std::string event;
+	std::string stop;
+	unsigned long weight;
+	std::size_t line;
+};
+
+struct machine
+{
+	std::string initial;
+	std::vector<transition> transitions;
+};
+
+struct parse_error : public std::runtime_error
+{
+	parse_error(std::size_t line, const std::string &what) :
+		std::runtime_error (what),
+		line (line)
+	{
+	}
+
+	std::size_t line;
+};
+
+unsigned long parseWeight(const std::string &s, std::size_t line)
+{
+	char *end = nullptr;
+	unsigned long w = std::strtoul(s.c_str(), &end, 10);
+
+	if (s.empty() || *end != '\0') {
+		throw parse_error(line, "invalid weight '" + s + "'");
+	}
+
+	return w;
+}
+
+machine parseText(std::istream &in)
+{
+	machine m;
+	std::string text;
+	std::size_t line = 0;
+
+	while (std::getline(in, text)) {
+		++line;
+		text = text.substr(0, text.find('#'));
+
+		std::istringstream words(text);
+		std::vector<std::string> w;
+		std::string word;
+
+		while (words >> word) {
+			w.push_back(word);
+		}
+
+		if (w.empty()) {
+			continue;
+		}
+
+		if (w[0] == "initial") {
+			if (w.size() != 2) {
+				throw parse_error(line, "expected: initial State");
+			}
+
+			m.initial = w[1];
+		} else if (w.size() == 3 || w.size() == 4) {
+			m.transitions.push_back({w[0], w[1], w[2], w.size() == 4 ? parseWeight(w[3], line) : 0, line});
+		} else {
+			throw parse_error(line, "expected: StartState Event StopState [weight]");
+		}
+	}
+
+	return m;
+}
+
+// tokenizer for the subset of DOT used here
+class dot_lexer
+{
+public:
+	explicit dot_lexer(std::istream &in) :
+		in (in)
+	{
+	}
+
+	// next token, empty at the end of input
+	std::string next()
+	{
+		skip();
+
+		int c = in.get();
+
+		if (c == EOF) {
+			return std::string();
+		}
+
+		if (c == '"') {
+			std::string s;
+
+			while ((c = in.get()) != EOF && c != '"') {
+				if (c == '\\' && in.peek() != EOF) {
+					c = in.get();
+				}
+
+				count(c);
+				s += static_cast<char>(c);
+			}
+
+			if (c == EOF) {
+				throw parse_error(line, "unterminated string");
+			}
+
+			return s;
+		}
+
+		if (c == '-' && in.peek() == '>') {
+			in.get();
+			return "->";
+		}
+
+		if (std::strchr("{}[];,=", c)) {
+			return std::string(1, static_cast<char>(c));
+		}
+
+		std::string s(1, static_cast<char>(c));
+
+		while (in.peek() != EOF && isIdChar(in.peek())) {
+			s += static_cast<char>(in.get());
+		}
+
+		return s;
+	}
+
+	std::size_t line = 1;
+
+private:
+	// C++ type names are allowed unquoted, e.g. Ring<1> or ns::Idle
+	static bool isIdChar(int c)
+	{
+		return std::isalnum(c) || c == '_' || c == ':' || c == '<' || c == '>' || c == '.';
+	}
+
+	void count(int c)
+	{
+		if (c == '\n') {
+			++line;
+		}
+	}
+
+	void skip()
+	{
+		for (;;) {
+			int c = in.peek();
+
+			if (c == EOF) {
+				return;
+			} else if (std::isspace(c)) {
+				count(in.get());
+			} else if (c == '#') {
+				skipLine();
+			} else if (c == '/') {
+				in.get();
+
+				if (in.peek() == '/') {
+					skipLine();
+				} else if (in.peek() == '*') {
+					in.get();
+					int prev = 0;
+
+					while ((c = in.get()) != EOF && !(prev == '*' && c == '/')) {
+						count(c);
+						prev = c;
+					}
+				} else {
+					in.unget();
+					return;
+				}
+			} else {
+				return;
+			}
+		}
+	}
+
+	void skipLine()
+	{
+		int c;
+
+		while ((c = in.get()) != EOF && c != '\n') {
+		}
+
+		count(c);
+	}
+
+	std::istream &in;
+};
+
+std::map<std::string, std::string> parseAttributes(dot_lexer &lex, std::string &tok)
+{
+	std::map<std::string, std::string> attrs;
+
+	if (tok != "[") {
+		return attrs;
+	}
+
+	for (tok = lex.next(); tok != "]"; tok = lex.next()) {
+		if (tok == "," || tok == ";") {
+			continue;
+		}
+
+		if (tok.empty()) {
+			throw parse_error(lex.line, "unterminated attribute list");
+		}
+
+		std::string key = tok;
+
+		if (lex.next() != "=") {
+			throw parse_error(lex.line, "expected '=' after attribute " + key);
+		}
+
+		attrs[key] = lex.next();
+	}
+
+	tok = lex.next();
+	return attrs;
+}
+
+machine parseDot(std::istream &in)
+{
+	machine m;
+	dot_lexer lex(in);
+	std::string tok = lex.next();
+
+	if (tok == "strict") {
+		tok = lex.next();
+	}
+
+	if (tok != "digraph") {
+		throw parse_error(lex.line, "expected digraph");
+	}
+
+	tok = lex.next();
+
+	if (tok != "{") {
+		tok = lex.next();
+	}
+
+	if (tok != "{") {
+		throw parse_error(lex.line, "expected '{'");
+	}
+
+	for (tok = lex.next(); tok != "}"; ) {
+		if (tok.empty()) {
+			throw parse_error(lex.line, "unexpected end of input");
+		}
+
+		if (tok == ";") {
+			tok = lex.next();
+			continue;
+		}
+
+		std::string first = tok;
+		std::size_t line = lex.line;
+		tok = lex.next();
+
+		if (first == "graph" || first == "node" || first == "edge") {
+			parseAttributes(lex, tok);
+		} else if (tok == "=") {
+			// graph attribute
+			lex.next();
+			tok = lex.next();
+		} else if (tok == "->") {
+			std::string second = lex.next();
+			tok = lex.next();
+
+			auto attrs = parseAttributes(lex, tok);
+
+			if (attrs.find("label") == attrs.end()) {
+				throw parse_error(line, "edge " + first + " -> " + second + " needs event as label");
+			}
+
+			auto w = attrs.find("weight");
+			m.transitions.push_back({first, attrs["label"], second, w == attrs.end() ? 0 : parseWeight(w->second, line), line});
+		} else {
+			auto attrs = parseAttributes(lex, tok);
+
+			if (attrs["initial"] == "true") {
+				m.initial = first;
+			}
+		}
+	}
+
+	return m;
+}
+
+// index of s in v, appended if it is not there yet
+std::size_t indexOf(std::vector<std::string> &v, const std::string &s)
+{
+	auto it = std::find(v.begin(), v.end(), s);
+
+	if (it != v.end()) {
+		return it - v.begin();
+	}
+
+	v.push_back(s);
+	return v.size() - 1;
+}
+
+std::string guardOf(const std::string &path)
+{
+	std::string guard = "FSM_GEN_";
+
+	for (char c : path.substr(path.find_last_of("/\\") + 1)) {
+		guard += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(c)) : '_';
+	}
+
+	return guard;
+}
+
+void emit(std::ostream &out, const machine &m, const std::string &name, const std::string &ns,
+	const std::vector<std::string> &includes, const std::string &input, const std::string &output)
+{
+	// the same order of states fsm::transitions would derive
+	std::vector<std::string> states;
+	std::vector<std::string> events;
+
+	indexOf(states, m.initial.empty() ? m.transitions.front().start : m.initial);
+
+	for (const auto &t : m.transitions) {
+		indexOf(states, t.start);
+	}
+
+	for (const auto &t : m.transitions) {
+		indexOf(states, t.stop);
+	}
+
+	for (const auto &t : m.transitions) {
+		indexOf(events, t.event);
+	}
+
+	// dispatch needs transitions of every event sorted by start index
+	std::vector<transition> sorted = m.transitions;
+
+	std::stable_sort(sorted.begin(), sorted.end(), [&](const transition &a, const transition &b) {
+		std::size_t ea = indexOf(events, a.event);
+		std::size_t eb = indexOf(events, b.event);
+		return ea != eb ? ea < eb : indexOf(states, a.start) < indexOf(states, b.start);
+	});
+
+	for (std::size_t i = 1; i < sorted.size(); ++i) {
+		if (sorted[i].event == sorted[i - 1].event && sorted[i].start == sorted[i - 1].start) {
+			throw parse_error(sorted[i].line, "second transition from " + sorted[i].start + " on " + sorted[i].event);
+		}
+	}
+
+	const std::string guard = guardOf(output);
+
+	out << "// generated by fsm-gen from " << input << ", do not edit\n";
+	out << "#ifndef " << guard << "\n";
+	out << "#define " << guard << "\n\n";
+	out << "#include <fsm.hpp>\n";
+
+	for (const auto &inc : includes) {
+		out << "#include \"" << inc << "\"\n";
+	}
+
+	out << "\n";
+
+	if (!ns.empty()) {
+		out << "namespace " << ns << "\n{\n\n";
+	}
+
+	out << "using " << name << " = fsm::transitions<\n";
+	out << "\tfsm::state_order<\n";
+
+	for (std::size_t i = 0; i < states.size(); ++i) {
+		out << "\t\t" << states[i] << (i + 1 < states.size() ? "," : "") << " // " << i << "\n";
+	}
+
+	out << "\t>,\n";
+	out << "\tfsm::initial<" << states.front() << ">";
+
+	for (const auto &t : sorted) {
+		std::string tr = "fsm::transition<" + t.start + ", " + t.event + ", " + t.stop + ">";
+
+		if (t.weight) {
+			tr = "fsm::hot<" + tr + ", " + std::to_string(t.weight) + ">";
+		}
+
+		out << ",\n\tfsm::indexed<" << tr << ", "
+			<< indexOf(states, t.start) << ", " << indexOf(states, t.stop) << ">";
+	}
+
+	out << "\n>;\n";
+
+	if (!ns.empty()) {
+		out << "\n} // namespace " << ns << "\n";
+	}
+
+	out << "\n#endif // " << guard << "\n";
+}
+
+bool endsWith(const std::string &s, const std::string &suffix)
+{
+	return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int usage()
+{
+	std::cerr << "usage: fsm-gen [--namespace NS] [--include HEADER]... NAME INPUT OUTPUT\n";
+	return 2;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	std::string ns;
+	std::vector<std::string> includes;
+	std::vector<std::string> args;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg == "--namespace" && i + 1 < argc) {
+			ns = argv[++i];
+		} else if (arg == "--include" && i + 1 < argc) {
+			includes.push_back(argv[++i]);
+		} else if (arg.compare(0, 2, "--") == 0) {
+			return usage();
+		} else {
+			args.push_back(arg);
+		}
+	}
+
+	if (args.size() != 3) {
+		return usage();
+	}
+
+	const std::string &name = args[0];
+	const std::string &input = args[1];
+	const std::string &output = args[2];
+
+	std::ifstream in(input);
+
+	if (!in) {
+		std::cerr << input << ": can't open\n";
+		return 1;
+	}
+
+	try {
+		machine m = endsWith(input, ".dot") || endsWith(input, ".gv") ? parseDot(in) : parseText(in);
+
+		if (m.transitions.empty()) {
+			throw parse_error(1, "no transitions");
+		}
+
+		// write whole header at once so a failed run leaves no partial output
+		std::ostringstream header;
+		emit(header, m, name, ns, includes, input, output);
+
+		std::ofstream out(output);
+		out << header.str();
+
+		if (!out) {
+			std::cerr << output << ": can't write\n";
+			return 1;
+		}
+	} catch (const parse_error &e) {
+		std::cerr << input << ":" << e.line << ": " << e.what() << "\n";
+		return 1;
+	}
+
+	return 0;
+}